@@ -0,0 +1,234 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+/**
+ * @file	 bench_headless.c
+ * @brief	renders a synthetic view tree through tealeaf_context, draw_textures
+ *			and texture_manager against the recording gl backend, reporting the
+ *			cpu time per frame and the gl work each frame would submit.
+ *
+ *			Build from the directory containing core/:
+ *			cc -O2 -fcommon -DGL_RECORDING -I. -Icore -Icore/deps -Icore/bench/headless \
+ *				core/bench/bench_headless.c core/bench/headless_stubs.c \
+ *				core/platform/gl_recording.c core/draw_textures.c core/gl_state.c \
+ *				core/geometry.c core/rgba.c core/tealeaf_canvas.c core/tealeaf_context.c \
+ *				core/tealeaf_shaders.c core/texture_2d.c core/texture_manager.c \
+ *				core/draw_recorder.c core/deps/lodepng/lodepng.c -lm -lpthread
+ *
+ *			Usage: a.out [views] [frames] [capture]
+ *			Given a capture path, one frame is also written there for bench_replay.
+ */
+#include "core/draw_recorder.h"
+#include "core/draw_textures.h"
+#include "core/gl_state.h"
+#include "core/tealeaf_canvas.h"
+#include "core/tealeaf_context.h"
+#include "core/tealeaf_shaders.h"
+#include "core/texture_manager.h"
+#include "platform/gl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define SCREEN_WIDTH 1024
+#define SCREEN_HEIGHT 768
+#define TEXTURES 8
+#define TEXTURE_SIZE 512
+#define CHILDREN 4
+
+typedef struct bench_view_t {
+	float x;
+	float y;
+	float r;
+	float scale;
+	float opacity;
+	rect_2d src;
+	rect_2d dest;
+	int texture;
+	// draw a solid fill instead of an image
+	bool fill;
+	rgba color;
+	int first_child;
+	int child_count;
+} bench_view;
+
+static bench_view *views;
+static int view_count;
+static char urls[TEXTURES][32];
+
+/**
+ * @name	now
+ * @brief	gets the current time in microseconds
+ * @retval	double - current time in microseconds
+ */
+static double now() {
+	struct timeval n;
+	gettimeofday(&n, NULL);
+	return (n.tv_sec * 1000.0 * 1000.0) + n.tv_usec;
+}
+
+/**
+ * @name	random_unit
+ * @brief	gets a random float in [0, 1)
+ * @retval	float - random number
+ */
+static float random_unit() {
+	return (rand() % 10000) / 10000.0f;
+}
+
+/**
+ * @name	build_tree
+ * @brief	builds a tree of view_count views where each view has up to
+ *			CHILDREN children, laid out breadth first
+ * @retval	NONE
+ */
+static void build_tree() {
+	int i;
+	int next_child = 1;
+	for (i = 0; i < view_count; i++) {
+		bench_view *v = &views[i];
+		v->x = random_unit() * (i ? 200 : SCREEN_WIDTH / 2);
+		v->y = random_unit() * (i ? 200 : SCREEN_HEIGHT / 2);
+		v->r = i % 5 == 0 ? random_unit() * 0.5f : 0;
+		v->scale = 0.75f + random_unit() * 0.5f;
+		v->opacity = i % 7 == 0 ? 0.5f : 1;
+		v->texture = rand() % TEXTURES;
+		v->src.x = (rand() % 8) * (TEXTURE_SIZE / 8);
+		v->src.y = (rand() % 8) * (TEXTURE_SIZE / 8);
+		v->src.width = v->src.height = TEXTURE_SIZE / 8;
+		v->dest.x = v->dest.y = 0;
+		v->dest.width = 32 + rand() % 64;
+		v->dest.height = 32 + rand() % 64;
+		v->fill = i % 11 == 0;
+		v->color.r = random_unit();
+		v->color.g = random_unit();
+		v->color.b = random_unit();
+		v->color.a = 1;
+
+		v->first_child = next_child;
+		v->child_count = view_count - next_child < CHILDREN ? view_count - next_child : CHILDREN;
+		if (v->child_count < 0) {
+			v->child_count = 0;
+		}
+		next_child += v->child_count;
+	}
+}
+
+/**
+ * @name	render_view
+ * @brief	renders a view and its subtree the way timestep views render
+ * @param	ctx - (context_2d *) context to render to
+ * @param	index - (int) index of the view to render
+ * @retval	NONE
+ */
+static void render_view(context_2d *ctx, int index) {
+	bench_view *v = &views[index];
+	context_2d_save(ctx);
+	context_2d_translate(ctx, v->x, v->y);
+	if (v->r) {
+		context_2d_rotate(ctx, v->r);
+	}
+	context_2d_scale(ctx, v->scale, v->scale);
+	context_2d_setGlobalAlpha(ctx, context_2d_getGlobalAlpha(ctx) * v->opacity);
+
+	if (v->fill) {
+		context_2d_fillRect(ctx, &v->dest, &v->color, source_over);
+	} else {
+		context_2d_drawImage(ctx, 0, urls[v->texture], &v->src, &v->dest, 0);
+	}
+
+	int i;
+	for (i = 0; i < v->child_count; i++) {
+		render_view(ctx, v->first_child + i);
+	}
+	context_2d_restore(ctx);
+}
+
+/**
+ * @name	render_frame
+ * @brief	renders one frame the way core_tick does
+ * @param	ctx - (context_2d *) onscreen context
+ * @retval	NONE
+ */
+static void render_frame(context_2d *ctx) {
+	gl_state_invalidate_bindings();
+	context_2d_clear(ctx);
+	render_view(ctx, 0);
+	draw_textures_flush();
+}
+
+int main(int argc, char **argv) {
+	view_count = argc > 1 ? atoi(argv[1]) : 2000;
+	int frames = argc > 2 ? atoi(argv[2]) : 500;
+	if (view_count < 1 || frames < 1) {
+		printf("usage: %s [views] [frames]\n", argv[0]);
+		return 1;
+	}
+
+	// mirrors core_init_gl
+	gl_recording_reset();
+	gl_state_reset();
+	tealeaf_shaders_init();
+	draw_textures_init();
+	tealeaf_canvas_init(0);
+	tealeaf_canvas_resize(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+	int i;
+	for (i = 0; i < TEXTURES; i++) {
+		GLuint name;
+		snprintf(urls[i], sizeof(urls[i]), "bench/sheet%d.png", i);
+		glGenTextures(1, &name);
+		gl_state_bind_texture(name);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TEXTURE_SIZE, TEXTURE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		texture_2d *tex = texture_manager_add_texture_from_image(texture_manager_get(), urls[i], name, TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_SIZE);
+		tex->loaded = true;
+	}
+
+	srand(1);
+	views = (bench_view *) calloc(view_count, sizeof(bench_view));
+	build_tree();
+
+	context_2d *ctx = context_2d_get_onscreen();
+	if (argc > 3) {
+		draw_recorder_capture_frame(argv[3]);
+	}
+	draw_recorder_frame_begin();
+	render_frame(ctx);
+	draw_recorder_frame_end();
+	gl_recording_reset_stats();
+	draw_textures_reset_stats();
+	unsigned int suppressed = gl_state_get_suppressed_calls();
+
+	double start = now();
+	for (i = 0; i < frames; i++) {
+		render_frame(ctx);
+	}
+	double elapsed = now() - start;
+
+	gl_recording_stats *gl = gl_recording_get_stats();
+	draw_textures_stats *batch = draw_textures_get_stats();
+	printf("%d views, %d frames\n", view_count, frames);
+	printf("cpu             %8.1f us/frame\n", elapsed / frames);
+	printf("gl calls        %8.1f /frame\n", (double) gl->calls / frames);
+	printf("draw calls      %8.1f /frame\n", (double) gl->draw_calls / frames);
+	printf("vertices        %8.1f /frame\n", (double) gl->vertices / frames);
+	printf("state changes   %8.1f /frame\n", (double) gl->state_changes / frames);
+	printf("texture binds   %8.1f /frame\n", (double) gl->texture_binds / frames);
+	printf("buffer bytes    %8.1f /frame\n", (double) gl->buffer_bytes / frames);
+	printf("suppressed      %8.1f /frame\n", (double) (gl_state_get_suppressed_calls() - suppressed) / frames);
+	printf("culled quads    %8.1f /frame\n", (double) batch->culled_quads / frames);
+	printf("draws saved     %8.1f /frame\n", (double) batch->draw_calls_saved / frames);
+	return 0;
+}
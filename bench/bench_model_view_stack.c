@@ -0,0 +1,286 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+/**
+ * @file	 bench_model_view_stack.c
+ * @brief	walks deep view trees the way the view renderer does, saving,
+ *			transforming and restoring the context for every view, comparing
+ *			the 2x3 model view stack of context_2d against the 3x3 stack it
+ *			replaced.
+ *
+ *			Build from the directory containing core/:
+ *			cc -O2 -fcommon -DGL_RECORDING -I. -Icore -Icore/deps -Icore/bench/headless \
+ *				core/bench/bench_model_view_stack.c core/bench/headless_stubs.c \
+ *				core/platform/gl_recording.c core/draw_textures.c core/gl_state.c \
+ *				core/geometry.c core/rgba.c core/tealeaf_canvas.c core/tealeaf_context.c \
+ *				core/tealeaf_shaders.c core/texture_2d.c core/texture_manager.c \
+ *				core/draw_recorder.c core/deps/lodepng/lodepng.c -lm -lpthread
+ *
+ *			Usage: a.out [depth] [frames]
+ */
+#include "core/draw_textures.h"
+#include "core/gl_state.h"
+#include "core/tealeaf_canvas.h"
+#include "core/tealeaf_context.h"
+#include "core/tealeaf_shaders.h"
+#include "platform/gl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define SCREEN_WIDTH 1024
+#define SCREEN_HEIGHT 768
+#define CHILDREN 2
+
+typedef struct bench_node_t {
+	float x;
+	float y;
+	float r;
+	float scale;
+	float opacity;
+} bench_node;
+
+// the 3x3 stack context_2d used before
+typedef struct legacy_stack_t {
+	float globalAlpha[MODEL_VIEW_STACK_SIZE];
+	matrix_3x3 modelView[MODEL_VIEW_STACK_SIZE];
+	rect_2d clipStack[MODEL_VIEW_STACK_SIZE];
+	unsigned int mvp;
+} legacy_stack;
+
+static bench_node *nodes = NULL;
+static int node_count = 0;
+static int depth = 0;
+static legacy_stack legacy;
+static double checksum = 0;
+
+/**
+ * @name	now
+ * @brief	gets the current time in microseconds
+ * @retval	double - current time in microseconds
+ */
+static double now() {
+	struct timeval n;
+	gettimeofday(&n, NULL);
+	return (n.tv_sec * 1000.0 * 1000.0) + n.tv_usec;
+}
+
+/**
+ * @name	build_tree
+ * @brief	fills a complete tree in breadth first order. A share of the nodes
+ *			sit at the origin of their parent untransformed, like the layers
+ *			and containers of real view trees.
+ * @param	at_origin - (int) percentage of nodes left untransformed
+ * @retval	NONE
+ */
+static void build_tree(int at_origin) {
+	int i;
+	srand(1);
+	for (i = 0; i < node_count; i++) {
+		bench_node *n = &nodes[i];
+		n->x = n->y = n->r = 0;
+		n->scale = n->opacity = 1;
+		if (rand() % 100 >= at_origin) {
+			n->x = rand() % 64;
+			n->y = rand() % 64;
+			n->r = (rand() % 8 == 0) ? (rand() % 628) / 100.0f : 0;
+			n->scale = (rand() % 8 == 0) ? 0.5f + (rand() % 100) / 100.0f : 1;
+		}
+		n->opacity = (rand() % 16 == 0) ? 0.5f : 1;
+	}
+}
+
+/**
+ * @name	walk_context
+ * @brief	walks the subtree of a node through the context_2d stack
+ * @param	ctx - (context_2d *) context to walk with
+ * @param	i - (int) index of the node
+ * @retval	NONE
+ */
+static void walk_context(context_2d *ctx, int i) {
+	bench_node *n = &nodes[i];
+	context_2d_save(ctx);
+	context_2d_translate(ctx, n->x, n->y);
+	context_2d_rotate(ctx, n->r);
+	if (n->scale != 1) {
+		context_2d_scale(ctx, n->scale, n->scale);
+	}
+	if (n->opacity != 1) {
+		context_2d_setGlobalAlpha(ctx, context_2d_getGlobalAlpha(ctx) * n->opacity);
+	}
+
+	// stands in for the draw, which reads the model view
+	const matrix_2x3 *m = context_2d_get_model_view(ctx);
+	checksum += m->m02 + m->m12;
+
+	int child;
+	for (child = i * CHILDREN + 1; child <= i * CHILDREN + CHILDREN && child < node_count; child++) {
+		walk_context(ctx, child);
+	}
+	context_2d_restore(ctx);
+}
+
+/**
+ * @name	legacy_save
+ * @brief	the old context_2d_save, copying the model view with the alpha and
+ *			clip. Kept out of line like the context_2d functions it stands in for.
+ * @retval	NONE
+ */
+static __attribute__((noinline)) void legacy_save() {
+	unsigned int mvp = ++legacy.mvp;
+	legacy.globalAlpha[mvp] = legacy.globalAlpha[mvp - 1];
+	legacy.modelView[mvp] = legacy.modelView[mvp - 1];
+	legacy.clipStack[mvp] = legacy.clipStack[mvp - 1];
+}
+
+/**
+ * @name	legacy_restore
+ * @brief	the old context_2d_restore
+ * @retval	NONE
+ */
+static __attribute__((noinline)) void legacy_restore() {
+	legacy.mvp--;
+}
+
+/**
+ * @name	legacy_translate
+ * @brief	the old context_2d_translate
+ * @param	x - (float) x offset
+ * @param	y - (float) y offset
+ * @retval	NONE
+ */
+static __attribute__((noinline)) void legacy_translate(float x, float y) {
+	if (x != 0 || y != 0) {
+		matrix_3x3_translate(&legacy.modelView[legacy.mvp], x, y);
+	}
+}
+
+/**
+ * @name	legacy_rotate
+ * @brief	the old context_2d_rotate
+ * @param	angle - (float) angle in radians
+ * @retval	NONE
+ */
+static __attribute__((noinline)) void legacy_rotate(float angle) {
+	if (angle != 0) {
+		matrix_3x3_rotate(&legacy.modelView[legacy.mvp], angle);
+	}
+}
+
+/**
+ * @name	legacy_scale
+ * @brief	the old context_2d_scale
+ * @param	x - (float) horizontal scale
+ * @param	y - (float) vertical scale
+ * @retval	NONE
+ */
+static __attribute__((noinline)) void legacy_scale(float x, float y) {
+	matrix_3x3_scale(&legacy.modelView[legacy.mvp], x, y);
+}
+
+/**
+ * @name	walk_legacy
+ * @brief	walks the subtree of a node through the old stack
+ * @param	i - (int) index of the node
+ * @retval	NONE
+ */
+static void walk_legacy(int i) {
+	bench_node *n = &nodes[i];
+	legacy_save();
+	legacy_translate(n->x, n->y);
+	legacy_rotate(n->r);
+	if (n->scale != 1) {
+		legacy_scale(n->scale, n->scale);
+	}
+	if (n->opacity != 1) {
+		legacy.globalAlpha[legacy.mvp] *= n->opacity;
+	}
+
+	matrix_3x3 *m = &legacy.modelView[legacy.mvp];
+	checksum += m->m02 + m->m12;
+
+	int child;
+	for (child = i * CHILDREN + 1; child <= i * CHILDREN + CHILDREN && child < node_count; child++) {
+		walk_legacy(child);
+	}
+	legacy_restore();
+}
+
+/**
+ * @name	run
+ * @brief	times walks of the tree through both stacks
+ * @param	ctx - (context_2d *) context to walk with
+ * @param	at_origin - (int) percentage of nodes left untransformed
+ * @param	frames - (int) number of walks to time
+ * @retval	NONE
+ */
+static void run(context_2d *ctx, int at_origin, int frames) {
+	int i;
+	build_tree(at_origin);
+
+	checksum = 0;
+	walk_legacy(0);
+	double start = now();
+	for (i = 0; i < frames; i++) {
+		walk_legacy(0);
+	}
+	double legacy_time = (now() - start) / frames;
+	double legacy_checksum = checksum;
+
+	checksum = 0;
+	walk_context(ctx, 0);
+	start = now();
+	for (i = 0; i < frames; i++) {
+		walk_context(ctx, 0);
+	}
+	double context_time = (now() - start) / frames;
+
+	printf("%3d%% at origin   3x3 full copy %8.1f us   2x3 context_2d %8.1f us   (checksums %.0f %.0f)\n",
+	       at_origin, legacy_time, context_time, legacy_checksum, checksum);
+}
+
+int main(int argc, char **argv) {
+	depth = argc > 1 ? atoi(argv[1]) : 14;
+	int frames = argc > 2 ? atoi(argv[2]) : 200;
+	if (depth < 1 || depth >= MODEL_VIEW_STACK_SIZE - 1 || frames < 1) {
+		printf("usage: %s [depth] [frames]\n", argv[0]);
+		return 1;
+	}
+
+	// mirrors core_init_gl
+	gl_recording_reset();
+	gl_state_reset();
+	tealeaf_shaders_init();
+	draw_textures_init();
+	tealeaf_canvas_init(0);
+	tealeaf_canvas_resize(SCREEN_WIDTH, SCREEN_HEIGHT);
+	context_2d *ctx = context_2d_get_onscreen();
+
+	node_count = (1 << depth) - 1;
+	nodes = (bench_node *) malloc(node_count * sizeof(bench_node));
+	legacy.mvp = 0;
+	legacy.globalAlpha[0] = 1;
+	matrix_3x3_identity(&legacy.modelView[0]);
+	legacy.clipStack[0].x = legacy.clipStack[0].y = 0;
+	legacy.clipStack[0].width = legacy.clipStack[0].height = -1;
+
+	printf("%d views, depth %d, %d frames\n", node_count, depth, frames);
+	run(ctx, 0, frames);
+	run(ctx, 50, frames);
+	run(ctx, 90, frames);
+
+	free(nodes);
+	return 0;
+}
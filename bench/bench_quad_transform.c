@@ -0,0 +1,144 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+/**
+ * @file	 bench_quad_transform.c
+ * @brief	compares transforming quads one at a time into the draw_textures
+ *			vertex layout against the bulk matrix_2x3_transform_quads kernel.
+ *
+ *			Build from the directory containing core/:
+ *			cc -O2 -I. core/bench/bench_quad_transform.c core/geometry.c -lm
+ */
+#include "core/geometry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+
+#define QUADS 5000
+#define FRAMES 2000
+
+// same size and position layout as the draw_textures vertex
+typedef struct bench_vertex_t {
+	float srcX;
+	float srcY;
+	float destX;
+	float destY;
+	unsigned char color[4];
+	unsigned char add_color[4];
+	unsigned char tex_index[4];
+} bench_vertex;
+
+static matrix_2x3 model_views[QUADS];
+static rect_2d rects[QUADS];
+static bench_vertex vertices[4 * QUADS];
+
+/**
+ * @name	now
+ * @brief	gets the current time in microseconds
+ * @retval	double - current time in microseconds
+ */
+static double now() {
+	struct timeval n;
+	gettimeofday(&n, NULL);
+	return (n.tv_sec * 1000.0 * 1000.0) + n.tv_usec;
+}
+
+/**
+ * @name	transform_one_at_a_time
+ * @brief	the per-quad path draw_textures_item used, one matrix multiply and
+ *			a float by float scatter for every quad
+ * @retval	NONE
+ */
+static void transform_one_at_a_time() {
+	int i;
+	for (i = 0; i < QUADS; i++) {
+		bench_vertex *v = &vertices[4 * i];
+		float x1, y1, x2, y2, x3, y3, x4, y4;
+		matrix_2x3_multiply(&model_views[i], &rects[i], &x1, &y1, &x2, &y2, &x3, &y3, &x4, &y4);
+		v[0].destX = x1;
+		v[0].destY = y1;
+		v[1].destX = x2;
+		v[1].destY = y2;
+		v[2].destX = x4;
+		v[2].destY = y4;
+		v[3].destX = x3;
+		v[3].destY = y3;
+	}
+}
+
+/**
+ * @name	transform_in_bulk
+ * @brief	the bulk kernel draw_textures_flush uses
+ * @retval	NONE
+ */
+static void transform_in_bulk() {
+	matrix_2x3_transform_quads(model_views, rects, QUADS, &vertices[0].destX, sizeof(bench_vertex));
+}
+
+/**
+ * @name	checksum
+ * @brief	sums the vertex positions so the compiler keeps the work
+ * @retval	double - sum of all vertex positions
+ */
+static double checksum() {
+	double sum = 0;
+	int i;
+	for (i = 0; i < 4 * QUADS; i++) {
+		sum += vertices[i].destX + vertices[i].destY;
+	}
+	return sum;
+}
+
+/**
+ * @name	run
+ * @brief	times FRAMES calls of the given transform
+ * @param	name - (const char *) label to print
+ * @param	transform - (void (*)()) transform to time
+ * @retval	NONE
+ */
+static void run(const char *name, void (*transform)()) {
+	int i;
+	transform();
+	double start = now();
+	for (i = 0; i < FRAMES; i++) {
+		transform();
+	}
+	double elapsed = now() - start;
+	printf("%-18s %8.1f us/frame  %6.2f ns/quad  (checksum %.1f)\n", name, elapsed / FRAMES,
+	       1000.0 * elapsed / ((double) FRAMES * QUADS), checksum());
+}
+
+int main(int argc, char **argv) {
+	int i;
+	srand(1);
+	for (i = 0; i < QUADS; i++) {
+		matrix_2x3_identity(&model_views[i]);
+		matrix_2x3_translate(&model_views[i], rand() % 1024, rand() % 768);
+		if (i % 4 == 0) {
+			matrix_2x3_rotate(&model_views[i], (rand() % 628) / 100.0f);
+		}
+		matrix_2x3_scale(&model_views[i], 0.5f + (rand() % 100) / 100.0f, 0.5f + (rand() % 100) / 100.0f);
+		rects[i].x = 0;
+		rects[i].y = 0;
+		rects[i].width = 16 + rand() % 64;
+		rects[i].height = 16 + rand() % 64;
+	}
+
+	printf("%d quads, %d frames\n", QUADS, FRAMES);
+	run("one at a time", transform_one_at_a_time);
+	run("bulk kernel", transform_in_bulk);
+	return 0;
+}
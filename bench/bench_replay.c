@@ -0,0 +1,139 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+/**
+ * @file	 bench_replay.c
+ * @brief	replays a frame captured with draw_recorder_capture_frame through
+ *			the renderer against the recording gl backend, reporting the cpu time
+ *			per frame and the gl work each replay submits. Textures are created
+ *			empty with the sizes they had when captured.
+ *
+ *			Build from the directory containing core/:
+ *			cc -O2 -fcommon -DGL_RECORDING -I. -Icore -Icore/deps -Icore/bench/headless \
+ *				core/bench/bench_replay.c core/bench/headless_stubs.c core/draw_recorder.c \
+ *				core/platform/gl_recording.c core/draw_textures.c core/gl_state.c \
+ *				core/geometry.c core/rgba.c core/tealeaf_canvas.c core/tealeaf_context.c \
+ *				core/tealeaf_shaders.c core/texture_2d.c core/texture_manager.c \
+ *				core/deps/lodepng/lodepng.c -lm -lpthread
+ *
+ *			Usage: a.out capture [frames]
+ */
+#include "core/draw_recorder.h"
+#include "core/draw_textures.h"
+#include "core/gl_state.h"
+#include "core/tealeaf_canvas.h"
+#include "core/tealeaf_context.h"
+#include "core/tealeaf_shaders.h"
+#include "core/texture_manager.h"
+#include "platform/gl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define SCREEN_WIDTH 1024
+#define SCREEN_HEIGHT 768
+
+/**
+ * @name	now
+ * @brief	gets the current time in microseconds
+ * @retval	double - current time in microseconds
+ */
+static double now() {
+	struct timeval n;
+	gettimeofday(&n, NULL);
+	return (n.tv_sec * 1000.0 * 1000.0) + n.tv_usec;
+}
+
+/**
+ * @name	create_textures
+ * @brief	creates an empty texture for every texture of the recording, and a
+ *			context for every offscreen canvas
+ * @param	recording - (draw_recording *) recording to create textures for
+ * @retval	NONE
+ */
+static void create_textures(draw_recording *recording) {
+	int i;
+	for (i = 0; i < draw_recording_get_texture_count(recording); i++) {
+		int width, height, original_width, original_height;
+		bool is_canvas;
+		const char *url = draw_recording_get_texture(recording, i, &width, &height, &original_width, &original_height, &is_canvas);
+
+		GLuint name;
+		glGenTextures(1, &name);
+		gl_state_bind_texture(name);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		texture_2d *tex = texture_2d_new_from_image(strdup(url), name, width, height, original_width, original_height);
+		texture_manager_add_texture(texture_manager_get(), tex, is_canvas);
+		tex->loaded = true;
+		if (is_canvas) {
+			context_2d_new(tealeaf_canvas_get(), url, name);
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		printf("usage: %s capture [frames]\n", argv[0]);
+		return 1;
+	}
+	int frames = argc > 2 ? atoi(argv[2]) : 500;
+
+	// mirrors core_init_gl
+	gl_recording_reset();
+	gl_state_reset();
+	tealeaf_shaders_init();
+	draw_textures_init();
+	tealeaf_canvas_init(0);
+	tealeaf_canvas_resize(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+	draw_recording *recording = draw_recording_load(argv[1]);
+	if (!recording) {
+		return 1;
+	}
+	create_textures(recording);
+
+	draw_recording_replay(recording);
+	draw_textures_flush();
+	gl_recording_reset_stats();
+	draw_textures_reset_stats();
+	unsigned int suppressed = gl_state_get_suppressed_calls();
+
+	int i;
+	double start = now();
+	for (i = 0; i < frames; i++) {
+		gl_state_invalidate_bindings();
+		draw_recording_replay(recording);
+		draw_textures_flush();
+	}
+	double elapsed = now() - start;
+
+	gl_recording_stats *gl = gl_recording_get_stats();
+	draw_textures_stats *batch = draw_textures_get_stats();
+	printf("%s: %lu bytes, %d textures, %d frames\n", argv[1], (unsigned long) draw_recording_get_size(recording),
+	       draw_recording_get_texture_count(recording), frames);
+	printf("cpu             %8.1f us/frame\n", elapsed / frames);
+	printf("gl calls        %8.1f /frame\n", (double) gl->calls / frames);
+	printf("draw calls      %8.1f /frame\n", (double) gl->draw_calls / frames);
+	printf("vertices        %8.1f /frame\n", (double) gl->vertices / frames);
+	printf("state changes   %8.1f /frame\n", (double) gl->state_changes / frames);
+	printf("texture binds   %8.1f /frame\n", (double) gl->texture_binds / frames);
+	printf("buffer bytes    %8.1f /frame\n", (double) gl->buffer_bytes / frames);
+	printf("suppressed      %8.1f /frame\n", (double) (gl_state_get_suppressed_calls() - suppressed) / frames);
+	printf("culled quads    %8.1f /frame\n", (double) batch->culled_quads / frames);
+	printf("draws saved     %8.1f /frame\n", (double) batch->draw_calls_saved / frames);
+	draw_recording_free(recording);
+	return 0;
+}
@@ -0,0 +1,117 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+/**
+ * @file	 headless_stubs.c
+ * @brief	stands in for the platform layer, javascript and image decoding so
+ *			the renderer can be linked into the headless benchmarks. Textures
+ *			are never loaded from urls, benchmarks register them directly.
+ */
+#include "core/config.h"
+#include "core/core.h"
+#include "core/events.h"
+#include "core/image_loader.h"
+#include "core/deps/jansson/jansson.h"
+#include "platform/native.h"
+#include "platform/resource_loader.h"
+#include "platform/threads.h"
+#include <stdlib.h>
+
+static int screen_width = 1024;
+static int screen_height = 768;
+
+bool config_get_remote_loading() {
+	return false;
+}
+
+void config_set_screen_width(int width) {
+	screen_width = width;
+}
+
+int config_get_screen_width() {
+	return screen_width;
+}
+
+void config_set_screen_height(int height) {
+	screen_height = height;
+}
+
+int config_get_screen_height() {
+	return screen_height;
+}
+
+void core_check_gl_error() {
+}
+
+void core_dispatch_event(const char *event) {
+	(void) event;
+}
+
+void set_halfsized_textures(bool on) {
+	(void) on;
+}
+
+unsigned char *load_image_from_memory(unsigned char *bits, long bits_length, int *width, int *height, int *channels) {
+	(void) bits; (void) bits_length; (void) width; (void) height; (void) channels;
+	return NULL;
+}
+
+void launch_remote_texture_load(const char *url) {
+	(void) url;
+}
+
+char *resource_loader_string_from_url(const char *url) {
+	(void) url;
+	return NULL;
+}
+
+bool resource_loader_load_image_with_c(texture_2d *texture) {
+	(void) texture;
+	return false;
+}
+
+json_t *json_loads(const char *input, size_t flags, json_error_t *error) {
+	(void) input; (void) flags; (void) error;
+	return NULL;
+}
+
+json_t *json_object_get(const json_t *object, const char *key) {
+	(void) object; (void) key;
+	return NULL;
+}
+
+json_int_t json_integer_value(const json_t *integer) {
+	(void) integer;
+	return 0;
+}
+
+ThreadsThread threads_create_thread(ThreadsThreadProc proc, void *param) {
+	(void) proc; (void) param;
+	return THREADS_INVALID_THREAD;
+}
+
+void threads_join_thread(ThreadsThread *thread) {
+	(void) thread;
+}
+
+size_t strlcpy(char *dest, const char *src, size_t size) {
+	size_t len = strlen(src);
+	if (size > 0) {
+		size_t n = len < size - 1 ? len : size - 1;
+		memcpy(dest, src, n);
+		dest[n] = '\0';
+	}
+	return len;
+}
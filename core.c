@@ -25,6 +25,9 @@
 #include "core/tealeaf_canvas.h"
 #include "core/tealeaf_context.h"
 #include "core/tealeaf_shaders.h"
+#include "core/draw_textures.h"
+#include "core/gl_state.h"
+#include "core/draw_recorder.h"
 #include "core/url_loader.h"
 #include "core/log.h"
 #include "core/events.h"
@@ -133,7 +136,10 @@ void core_init(const char *entry_point,
 void core_init_gl(int framebuffer_name) {
 	LOG("{core} Initializing OpenGL");
 
+	// nothing from a previous context survives
+	gl_state_reset();
 	tealeaf_shaders_init();
+	draw_textures_init();
 	m_framebuffer_name = framebuffer_name;
 
 	// If frame buffer id was invalid,
@@ -216,6 +222,10 @@ void calculate_size(texture_2d *tex, bool rotate) {
  * @retval	NONE
  */
 void core_tick(int dt) {
+	// the platform may have touched gl state since the last frame
+	gl_state_invalidate_bindings();
+	draw_recorder_frame_begin();
+
 	if (js_ready) {
 		core_timer_tick(dt);
 		js_tick(dt);
@@ -282,6 +292,8 @@ void core_tick(int dt) {
     if (js_ready) {
         core_check_gl_error();
     }
+
+	draw_recorder_frame_end();
 }
 
 /**
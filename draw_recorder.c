@@ -0,0 +1,939 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+/**
+ * @file	 draw_recorder.c
+ * @brief	captures the draw calls made through tealeaf_context into a compact
+ *			binary stream and replays them through the same functions.
+ *
+ *			A recording is a sequence of records, each a one byte type followed
+ *			by a fixed payload in native byte order. Textures are referenced by
+ *			url through a table of texture records written the first time each
+ *			texture is used. The model view, clip, alpha and filter are written
+ *			as state records only when they change, so draw records hold just
+ *			the texture and rectangles.
+ */
+#include "core/draw_recorder.h"
+#include "core/texture_manager.h"
+#include "core/deps/uthash/uthash.h"
+#include "core/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RECORDING_MAGIC "TLDR"
+#define RECORDING_VERSION 1
+// texture id of the onscreen context in bind records
+#define ONSCREEN_ID 0xFFFF
+#define MAX_TEXTURES 0xFFFF
+
+enum record_type {
+	RECORD_TEXTURE = 1,
+	RECORD_BIND,
+	RECORD_CLEAR,
+	RECORD_MODEL_VIEW,
+	RECORD_CLIP,
+	RECORD_ALPHA,
+	RECORD_FILTER,
+	RECORD_IMAGE,
+	RECORD_FILL_RECT,
+	RECORD_CLEAR_RECT
+};
+
+typedef struct recorded_texture_t {
+	char *url;
+	int id;
+	int width;
+	int height;
+	int original_width;
+	int original_height;
+	bool is_canvas;
+	UT_hash_handle hh;
+} recorded_texture;
+
+struct draw_recording_t {
+	unsigned char *data;
+	size_t size;
+	size_t capacity;
+
+	recorded_texture *textures_by_url;
+	recorded_texture **textures;
+	int texture_count;
+	int texture_capacity;
+
+	// state last written, later records only repeat what changed
+	context_2d *last_ctx;
+	bool has_state;
+	matrix_2x3 last_model_view;
+	rect_2d last_clip;
+	float last_alpha;
+	int last_filter_type;
+	rgba last_filter_color;
+
+	// what the records touch, see draw_recording_is_local
+	int bind_count;
+	int clip_count;
+	bool cleared;
+	// draws that were not recorded, see draw_recording_is_complete
+	bool skipped_draws;
+};
+
+typedef struct record_reader_t {
+	const unsigned char *p;
+	const unsigned char *end;
+	bool failed;
+} record_reader;
+
+draw_recording *draw_recorder_recording = NULL;
+static draw_recording *capture = NULL;
+static char *capture_path = NULL;
+
+/**
+ * @name	reserve
+ * @brief	makes room for more bytes at the end of a recording
+ * @param	recording - (draw_recording *) recording to grow
+ * @param	bytes - (size_t) number of bytes about to be written
+ * @retval	unsigned char* - where to write the bytes or NULL if out of memory
+ */
+static unsigned char *reserve(draw_recording *recording, size_t bytes) {
+	if (recording->size + bytes > recording->capacity) {
+		size_t capacity = recording->capacity ? 2 * recording->capacity : 4096;
+		while (capacity < recording->size + bytes) {
+			capacity *= 2;
+		}
+
+		unsigned char *data = (unsigned char *) realloc(recording->data, capacity);
+		if (!data) {
+			LOG("{recorder} WARNING: Unable to grow recording to %lu bytes", (unsigned long) capacity);
+			return NULL;
+		}
+		recording->data = data;
+		recording->capacity = capacity;
+	}
+
+	unsigned char *out = recording->data + recording->size;
+	recording->size += bytes;
+	return out;
+}
+
+/**
+ * @name	write_record
+ * @brief	appends a record of the given type and payload
+ * @param	recording - (draw_recording *) recording to append to
+ * @param	type - (int) record_type of the record
+ * @param	payload - (const void *) record payload
+ * @param	bytes - (size_t) size of the payload
+ * @retval	NONE
+ */
+static void write_record(draw_recording *recording, int type, const void *payload, size_t bytes) {
+	unsigned char *out = reserve(recording, 1 + bytes);
+	if (out) {
+		out[0] = (unsigned char) type;
+		if (bytes) {
+			memcpy(out + 1, payload, bytes);
+		}
+	}
+}
+
+/**
+ * @name	read_bytes
+ * @brief	reads bytes from a record stream, marking the reader as failed
+ *			when the stream is truncated
+ * @param	reader - (record_reader *) reader to read from
+ * @param	out - (void *) where to copy the bytes
+ * @param	bytes - (size_t) number of bytes to read
+ * @retval	bool - whether the bytes were read
+ */
+static bool read_bytes(record_reader *reader, void *out, size_t bytes) {
+	if (reader->failed || (size_t) (reader->end - reader->p) < bytes) {
+		reader->failed = true;
+		return false;
+	}
+
+	memcpy(out, reader->p, bytes);
+	reader->p += bytes;
+	return true;
+}
+
+/**
+ * @name	add_texture
+ * @brief	adds a texture to the table of a recording
+ * @param	recording - (draw_recording *) recording to add to
+ * @param	url - (const char *) url of the texture
+ * @param	sizes - (const int *) width, height, original width and height
+ * @param	is_canvas - (bool) whether the texture backs an offscreen context
+ * @retval	recorded_texture* - the table entry or NULL if the table is full
+ */
+static recorded_texture *add_texture(draw_recording *recording, const char *url, const int *sizes, bool is_canvas) {
+	if (recording->texture_count == MAX_TEXTURES) {
+		return NULL;
+	}
+
+	if (recording->texture_count == recording->texture_capacity) {
+		int capacity = recording->texture_capacity ? 2 * recording->texture_capacity : 64;
+		recorded_texture **textures = (recorded_texture **) realloc(recording->textures, capacity * sizeof(recorded_texture *));
+		if (!textures) {
+			return NULL;
+		}
+		recording->textures = textures;
+		recording->texture_capacity = capacity;
+	}
+
+	recorded_texture *entry = (recorded_texture *) malloc(sizeof(recorded_texture));
+	entry->url = strdup(url);
+	entry->id = recording->texture_count;
+	entry->width = sizes[0];
+	entry->height = sizes[1];
+	entry->original_width = sizes[2];
+	entry->original_height = sizes[3];
+	entry->is_canvas = is_canvas;
+	recording->textures[recording->texture_count++] = entry;
+	HASH_ADD_KEYPTR(hh, recording->textures_by_url, entry->url, strlen(entry->url), entry);
+	return entry;
+}
+
+/**
+ * @name	texture_id
+ * @brief	gets the id of a texture in a recording, writing a texture record
+ *			the first time the texture is used
+ * @param	recording - (draw_recording *) recording to look the texture up in
+ * @param	tex - (texture_2d *) texture to look up
+ * @retval	int - id of the texture or -1 if it could not be added
+ */
+static int texture_id(draw_recording *recording, texture_2d *tex) {
+	recorded_texture *entry = NULL;
+	HASH_FIND_STR(recording->textures_by_url, tex->url, entry);
+	if (entry) {
+		return entry->id;
+	}
+
+	int sizes[4] = {tex->width, tex->height, tex->originalWidth, tex->originalHeight};
+	entry = add_texture(recording, tex->url, sizes, tex->is_canvas);
+	if (!entry) {
+		return -1;
+	}
+
+	// id, is_canvas, sizes, url length and url
+	unsigned short id = entry->id;
+	unsigned short url_length = strlen(tex->url);
+	unsigned char is_canvas = tex->is_canvas;
+	unsigned char payload[2 + 1 + sizeof(sizes) + 2];
+	memcpy(payload, &id, 2);
+	payload[2] = is_canvas;
+	memcpy(payload + 3, sizes, sizeof(sizes));
+	memcpy(payload + 3 + sizeof(sizes), &url_length, 2);
+	unsigned char *out = reserve(recording, 1 + sizeof(payload) + url_length);
+	if (out) {
+		out[0] = RECORD_TEXTURE;
+		memcpy(out + 1, payload, sizeof(payload));
+		memcpy(out + 1 + sizeof(payload), tex->url, url_length);
+	}
+	return entry->id;
+}
+
+/**
+ * @name	draw_recording_new
+ * @brief	creates an empty recording
+ * @retval	draw_recording* - the new recording
+ */
+draw_recording *draw_recording_new() {
+	return (draw_recording *) calloc(1, sizeof(draw_recording));
+}
+
+/**
+ * @name	draw_recording_clear
+ * @brief	drops every record and texture of a recording, keeping its memory
+ * @param	recording - (draw_recording *) recording to clear
+ * @retval	NONE
+ */
+void draw_recording_clear(draw_recording *recording) {
+	int i;
+	HASH_CLEAR(hh, recording->textures_by_url);
+	for (i = 0; i < recording->texture_count; i++) {
+		free(recording->textures[i]->url);
+		free(recording->textures[i]);
+	}
+	recording->texture_count = 0;
+	recording->size = 0;
+	recording->last_ctx = NULL;
+	recording->has_state = false;
+	recording->bind_count = 0;
+	recording->clip_count = 0;
+	recording->cleared = false;
+	recording->skipped_draws = false;
+}
+
+/**
+ * @name	draw_recording_free
+ * @brief	frees a recording
+ * @param	recording - (draw_recording *) recording to free
+ * @retval	NONE
+ */
+void draw_recording_free(draw_recording *recording) {
+	if (!recording) {
+		return;
+	}
+
+	if (draw_recorder_recording == recording) {
+		draw_recorder_stop();
+	}
+	draw_recording_clear(recording);
+	free(recording->textures);
+	free(recording->data);
+	free(recording);
+}
+
+/**
+ * @name	draw_recording_get_size
+ * @brief	gets the size of the records of a recording
+ * @param	recording - (draw_recording *) recording to measure
+ * @retval	size_t - size in bytes
+ */
+size_t draw_recording_get_size(draw_recording *recording) {
+	return recording->size;
+}
+
+/**
+ * @name	draw_recording_get_texture_count
+ * @brief	gets the number of textures a recording references
+ * @param	recording - (draw_recording *) recording to query
+ * @retval	int - number of textures
+ */
+int draw_recording_get_texture_count(draw_recording *recording) {
+	return recording->texture_count;
+}
+
+/**
+ * @name	draw_recording_get_texture
+ * @brief	gets a texture referenced by a recording, as it was when recorded
+ * @param	recording - (draw_recording *) recording to query
+ * @param	index - (int) index of the texture
+ * @param	width - (int *) gets the texture width
+ * @param	height - (int *) gets the texture height
+ * @param	original_width - (int *) gets the original image width
+ * @param	original_height - (int *) gets the original image height
+ * @param	is_canvas - (bool *) gets whether the texture backs an offscreen context
+ * @retval	const char* - url of the texture
+ */
+const char *draw_recording_get_texture(draw_recording *recording, int index, int *width, int *height, int *original_width, int *original_height, bool *is_canvas) {
+	recorded_texture *entry = recording->textures[index];
+	*width = entry->width;
+	*height = entry->height;
+	*original_width = entry->original_width;
+	*original_height = entry->original_height;
+	*is_canvas = entry->is_canvas;
+	return entry->url;
+}
+
+/**
+ * @name	draw_recording_save
+ * @brief	writes a recording to a file
+ * @param	recording - (draw_recording *) recording to write
+ * @param	path - (const char *) path of the file
+ * @retval	bool - whether the file was written
+ */
+bool draw_recording_save(draw_recording *recording, const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		LOG("{recorder} WARNING: Unable to open %s for writing", path);
+		return false;
+	}
+
+	unsigned int version = RECORDING_VERSION;
+	unsigned int size = recording->size;
+	bool written = fwrite(RECORDING_MAGIC, 4, 1, file) == 1 &&
+	               fwrite(&version, sizeof(version), 1, file) == 1 &&
+	               fwrite(&size, sizeof(size), 1, file) == 1 &&
+	               (!size || fwrite(recording->data, size, 1, file) == 1);
+	if (fclose(file) || !written) {
+		LOG("{recorder} WARNING: Unable to write %s", path);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @name	draw_recording_load
+ * @brief	reads a recording written by draw_recording_save and rebuilds its
+ *			texture table
+ * @param	path - (const char *) path of the file
+ * @retval	draw_recording* - the recording or NULL if the file is not a valid recording
+ */
+draw_recording *draw_recording_load(const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		LOG("{recorder} WARNING: Unable to open %s", path);
+		return NULL;
+	}
+
+	char magic[4];
+	unsigned int version, size;
+	draw_recording *recording = NULL;
+	if (fread(magic, 4, 1, file) == 1 && !memcmp(magic, RECORDING_MAGIC, 4) &&
+	    fread(&version, sizeof(version), 1, file) == 1 && version == RECORDING_VERSION &&
+	    fread(&size, sizeof(size), 1, file) == 1) {
+		recording = draw_recording_new();
+		if (size && (!reserve(recording, size) || fread(recording->data, size, 1, file) != 1)) {
+			draw_recording_free(recording);
+			recording = NULL;
+		}
+	}
+	fclose(file);
+
+	if (!recording) {
+		LOG("{recorder} WARNING: %s is not a recording", path);
+		return NULL;
+	}
+
+	// texture records are read up front so textures can be created before replay
+	record_reader reader = {recording->data, recording->data + recording->size, false};
+	unsigned char type;
+	while (reader.p < reader.end && read_bytes(&reader, &type, 1)) {
+		size_t skip = 0;
+		switch (type) {
+			case RECORD_TEXTURE: {
+				unsigned short id, url_length;
+				unsigned char is_canvas;
+				int sizes[4];
+				char url[0x10000];
+				if (read_bytes(&reader, &id, 2) && read_bytes(&reader, &is_canvas, 1) &&
+				    read_bytes(&reader, sizes, sizeof(sizes)) && read_bytes(&reader, &url_length, 2) &&
+				    read_bytes(&reader, url, url_length)) {
+					url[url_length] = '\0';
+					if (id != recording->texture_count || !add_texture(recording, url, sizes, is_canvas)) {
+						reader.failed = true;
+					}
+				}
+				break;
+			}
+
+			case RECORD_BIND:
+				skip = 2;
+				break;
+
+			case RECORD_CLEAR:
+				break;
+
+			case RECORD_MODEL_VIEW:
+				skip = 6 * sizeof(float);
+				break;
+
+			case RECORD_CLIP:
+				skip = sizeof(rect_2d);
+				break;
+
+			case RECORD_ALPHA:
+				skip = sizeof(float);
+				break;
+
+			case RECORD_FILTER:
+				skip = 1 + sizeof(rgba);
+				break;
+
+			case RECORD_IMAGE:
+				skip = 2 + sizeof(int) + 2 * sizeof(rect_2d);
+				break;
+
+			case RECORD_FILL_RECT:
+				skip = sizeof(rect_2d) + sizeof(rgba) + sizeof(int);
+				break;
+
+			case RECORD_CLEAR_RECT:
+				skip = sizeof(rect_2d);
+				break;
+
+			default:
+				reader.failed = true;
+				break;
+		}
+
+		if (reader.failed || (size_t) (reader.end - reader.p) < skip) {
+			LOG("{recorder} WARNING: %s is corrupt", path);
+			draw_recording_free(recording);
+			return NULL;
+		}
+		reader.p += skip;
+	}
+
+	return recording;
+}
+
+/**
+ * @name	context_for_texture
+ * @brief	finds the context to replay a bind record into
+ * @param	recording - (draw_recording *) recording being replayed
+ * @param	id - (unsigned short) texture id of the bind record
+ * @retval	context_2d* - the context or NULL if it does not exist
+ */
+static context_2d *context_for_texture(draw_recording *recording, unsigned short id) {
+	if (id == ONSCREEN_ID) {
+		return context_2d_get_onscreen();
+	}
+
+	if (id >= recording->texture_count) {
+		return NULL;
+	}
+
+	texture_2d *tex = texture_manager_get_texture(texture_manager_get(), recording->textures[id]->url);
+	return tex ? tex->ctx : NULL;
+}
+
+/**
+ * @name	replay
+ * @brief	submits the draw calls of a recording through tealeaf_context.
+ *			Without a target each draw runs with the recorded context, model
+ *			view, clip, alpha and filter. With one, every draw goes to the
+ *			target under its current clip and filter, with the recorded model
+ *			view and alpha composed with the given ones.
+ * @param	recording - (draw_recording *) recording to replay
+ * @param	target - (context_2d *) context to draw to or NULL
+ * @param	transform - (const matrix_2x3 *) applied after the recorded model views
+ * @param	alpha_scale - (float) multiplies the recorded alpha
+ * @retval	NONE
+ */
+static void replay(draw_recording *recording, context_2d *target, const matrix_2x3 *transform, float alpha_scale) {
+	record_reader reader = {recording->data, recording->data + recording->size, false};
+	context_2d *ctx = target ? target : context_2d_get_onscreen();
+	matrix_2x3 model_view;
+	rect_2d clip = {0, 0, -1, -1};
+	float alpha = 1;
+	unsigned char filter_type = FILTER_NONE;
+	rgba filter_color = {0, 0, 0, 0};
+	matrix_2x3_identity(&model_view);
+
+	unsigned char type;
+	while (reader.p < reader.end && read_bytes(&reader, &type, 1)) {
+		unsigned short id = 0;
+		rect_2d src, dest;
+		rgba color;
+		int composite_op = 0;
+
+		switch (type) {
+			case RECORD_TEXTURE: {
+				// already in the texture table
+				unsigned char header[2 + 1 + 4 * sizeof(int)];
+				unsigned short url_length;
+				if (read_bytes(&reader, header, sizeof(header)) && read_bytes(&reader, &url_length, 2) &&
+				    (size_t) (reader.end - reader.p) >= url_length) {
+					reader.p += url_length;
+				} else {
+					reader.failed = true;
+				}
+				continue;
+			}
+
+			case RECORD_BIND:
+				if (read_bytes(&reader, &id, 2) && !target) {
+					ctx = context_for_texture(recording, id);
+					if (!ctx) {
+						LOG("{recorder} WARNING: Skipping draws to missing context %u", id);
+					}
+				}
+				continue;
+
+			case RECORD_MODEL_VIEW: {
+				float m[6];
+				if (read_bytes(&reader, m, sizeof(m))) {
+					model_view.m00 = m[0];
+					model_view.m01 = m[1];
+					model_view.m02 = m[2];
+					model_view.m10 = m[3];
+					model_view.m11 = m[4];
+					model_view.m12 = m[5];
+				}
+				continue;
+			}
+
+			case RECORD_CLIP:
+				read_bytes(&reader, &clip, sizeof(clip));
+				continue;
+
+			case RECORD_ALPHA:
+				read_bytes(&reader, &alpha, sizeof(alpha));
+				continue;
+
+			case RECORD_FILTER:
+				if (read_bytes(&reader, &filter_type, 1)) {
+					read_bytes(&reader, &filter_color, sizeof(filter_color));
+				}
+				continue;
+		}
+
+		// the rest are draws, read them even if there is no context to draw to
+		bool valid = false;
+		switch (type) {
+			case RECORD_CLEAR:
+				valid = true;
+				break;
+
+			case RECORD_IMAGE:
+				valid = read_bytes(&reader, &id, 2) && read_bytes(&reader, &composite_op, sizeof(int)) &&
+				        read_bytes(&reader, &src, sizeof(src)) && read_bytes(&reader, &dest, sizeof(dest)) &&
+				        id < recording->texture_count;
+				break;
+
+			case RECORD_FILL_RECT:
+				valid = read_bytes(&reader, &dest, sizeof(dest)) && read_bytes(&reader, &color, sizeof(color)) &&
+				        read_bytes(&reader, &composite_op, sizeof(int));
+				break;
+
+			case RECORD_CLEAR_RECT:
+				valid = read_bytes(&reader, &dest, sizeof(dest));
+				break;
+
+			default:
+				reader.failed = true;
+				break;
+		}
+
+		if (!valid || !ctx) {
+			continue;
+		}
+
+		context_2d_save(ctx);
+		int saved_filter_type = ctx->filter_type;
+		rgba saved_filter_color = ctx->filter_color;
+		if (target) {
+			matrix_2x3 m;
+			matrix_2x3_multiply(transform, &model_view, &m);
+			context_2d_setTransform(ctx, &m);
+			ctx->globalAlpha[ctx->mvp] = alpha * alpha_scale;
+		} else {
+			context_2d_setTransform(ctx, &model_view);
+			ctx->clipStack[ctx->mvp] = clip;
+			ctx->globalAlpha[ctx->mvp] = alpha;
+			ctx->filter_type = filter_type;
+			ctx->filter_color = filter_color;
+		}
+
+		switch (type) {
+			case RECORD_CLEAR:
+				context_2d_clear(ctx);
+				break;
+
+			case RECORD_IMAGE:
+				context_2d_drawImage(ctx, 0, recording->textures[id]->url, &src, &dest, composite_op);
+				break;
+
+			case RECORD_FILL_RECT:
+				context_2d_fillRect(ctx, &dest, &color, composite_op);
+				break;
+
+			case RECORD_CLEAR_RECT:
+				context_2d_clearRect(ctx, &dest);
+				break;
+		}
+
+		ctx->filter_type = saved_filter_type;
+		ctx->filter_color = saved_filter_color;
+		context_2d_restore(ctx);
+	}
+
+	if (reader.failed) {
+		LOG("{recorder} WARNING: Stopped replaying a truncated recording");
+	}
+}
+
+/**
+ * @name	draw_recording_replay
+ * @brief	submits the draw calls of a recording through tealeaf_context.
+ *			Each draw runs with the recorded model view, clip, alpha and filter
+ *			and the context state is restored afterwards.
+ * @param	recording - (draw_recording *) recording to replay
+ * @retval	NONE
+ */
+void draw_recording_replay(draw_recording *recording) {
+	replay(recording, NULL, NULL, 1);
+}
+
+/**
+ * @name	draw_recording_replay_into
+ * @brief	submits the draw calls of a local recording to a context, under the
+ *			context's current clip and filter. transform maps the model views
+ *			the draws were recorded with to the ones they are drawn with.
+ * @param	recording - (draw_recording *) recording to replay, see draw_recording_is_local
+ * @param	ctx - (context_2d *) context to draw to
+ * @param	transform - (const matrix_2x3 *) applied after the recorded model views
+ * @param	alpha_scale - (float) multiplies the recorded alpha of each draw
+ * @retval	NONE
+ */
+void draw_recording_replay_into(draw_recording *recording, context_2d *ctx, const matrix_2x3 *transform, float alpha_scale) {
+	replay(recording, ctx, transform, alpha_scale);
+}
+
+/**
+ * @name	draw_recording_is_local
+ * @brief	checks that a recording only draws to one context under one clip
+ *			and never clears it, so it can be replayed elsewhere in that
+ *			context with draw_recording_replay_into
+ * @param	recording - (draw_recording *) recording to check
+ * @param	ctx - (context_2d *) context the draws must go to
+ * @param	clip - (const rect_2d *) clip the draws must be made under
+ * @retval	bool - whether the recording is local
+ */
+bool draw_recording_is_local(draw_recording *recording, context_2d *ctx, const rect_2d *clip) {
+	return !recording->cleared && recording->bind_count <= 1 && recording->clip_count <= 1 &&
+	       (!recording->bind_count || recording->last_ctx == ctx) &&
+	       (!recording->clip_count || rect_2d_equals(&recording->last_clip, clip));
+}
+
+/**
+ * @name	draw_recording_is_complete
+ * @brief	checks whether every draw made while recording was recorded. Draws
+ *			of textures that had not loaded yet are skipped, so a recording
+ *			without them only matches the frame it was made in.
+ * @param	recording - (draw_recording *) recording to check
+ * @retval	bool - whether no draw was skipped
+ */
+bool draw_recording_is_complete(draw_recording *recording) {
+	return !recording->skipped_draws;
+}
+
+/**
+ * @name	draw_recorder_start
+ * @brief	starts capturing draw calls into a recording
+ * @param	recording - (draw_recording *) recording to append to
+ * @retval	NONE
+ */
+void draw_recorder_start(draw_recording *recording) {
+	recording->last_ctx = NULL;
+	recording->has_state = false;
+	draw_recorder_recording = recording;
+}
+
+/**
+ * @name	draw_recorder_stop
+ * @brief	stops capturing draw calls
+ * @retval	draw_recording* - the recording that was being captured into
+ */
+draw_recording *draw_recorder_stop() {
+	draw_recording *recording = draw_recorder_recording;
+	draw_recorder_recording = NULL;
+	return recording;
+}
+
+/**
+ * @name	draw_recorder_capture_frame
+ * @brief	captures the draw calls of the next frame into a file
+ * @param	path - (const char *) path of the file to write
+ * @retval	NONE
+ */
+void draw_recorder_capture_frame(const char *path) {
+	free(capture_path);
+	capture_path = strdup(path);
+}
+
+/**
+ * @name	draw_recorder_frame_begin
+ * @brief	starts a requested frame capture, called at the start of each frame
+ * @retval	NONE
+ */
+void draw_recorder_frame_begin() {
+	if (capture_path && !capture && !draw_recorder_recording) {
+		capture = draw_recording_new();
+		draw_recorder_start(capture);
+	}
+}
+
+/**
+ * @name	draw_recorder_frame_end
+ * @brief	writes a frame capture started this frame, called at the end of each frame
+ * @retval	NONE
+ */
+void draw_recorder_frame_end() {
+	if (!capture) {
+		return;
+	}
+
+	if (draw_recorder_recording == capture) {
+		draw_recorder_stop();
+	}
+	if (draw_recording_save(capture, capture_path)) {
+		LOG("{recorder} Captured frame to %s (%lu bytes, %d textures)", capture_path,
+		    (unsigned long) capture->size, capture->texture_count);
+	}
+	draw_recording_free(capture);
+	capture = NULL;
+	free(capture_path);
+	capture_path = NULL;
+}
+
+/**
+ * @name	draw_recorder_bind
+ * @brief	records a switch of the context being drawn to
+ * @param	ctx - (context_2d *) context being bound
+ * @retval	NONE
+ */
+void draw_recorder_bind(context_2d *ctx) {
+	draw_recording *recording = draw_recorder_recording;
+	if (!recording || recording->last_ctx == ctx) {
+		return;
+	}
+
+	int id = ONSCREEN_ID;
+	if (!ctx->on_screen) {
+		texture_2d *tex = texture_manager_get_texture(texture_manager_get(), ctx->url);
+		id = tex ? texture_id(recording, tex) : -1;
+		if (id < 0) {
+			return;
+		}
+	}
+
+	unsigned short payload = id;
+	write_record(recording, RECORD_BIND, &payload, 2);
+	recording->last_ctx = ctx;
+	recording->bind_count++;
+}
+
+/**
+ * @name	record_state
+ * @brief	records the parts of the draw state that changed since the last draw
+ * @param	recording - (draw_recording *) recording to write to
+ * @param	ctx - (context_2d *) context being drawn to
+ * @param	alpha - (float) alpha of the draw
+ * @retval	NONE
+ */
+static void record_state(draw_recording *recording, context_2d *ctx, float alpha) {
+	draw_recorder_bind(ctx);
+
+	const matrix_2x3 *model_view = context_2d_get_model_view(ctx);
+	if (!recording->has_state || memcmp(model_view, &recording->last_model_view, sizeof(matrix_2x3))) {
+		float m[6] = {model_view->m00, model_view->m01, model_view->m02, model_view->m10, model_view->m11, model_view->m12};
+		write_record(recording, RECORD_MODEL_VIEW, m, sizeof(m));
+		recording->last_model_view = *model_view;
+	}
+
+	const rect_2d *clip = &ctx->clipStack[ctx->mvp];
+	if (!recording->has_state || !rect_2d_equals(clip, &recording->last_clip)) {
+		write_record(recording, RECORD_CLIP, clip, sizeof(rect_2d));
+		recording->last_clip = *clip;
+		recording->clip_count++;
+	}
+
+	if (!recording->has_state || alpha != recording->last_alpha) {
+		write_record(recording, RECORD_ALPHA, &alpha, sizeof(alpha));
+		recording->last_alpha = alpha;
+	}
+
+	if (!recording->has_state || ctx->filter_type != recording->last_filter_type ||
+	    memcmp(&ctx->filter_color, &recording->last_filter_color, sizeof(rgba))) {
+		unsigned char payload[1 + sizeof(rgba)];
+		payload[0] = (unsigned char) ctx->filter_type;
+		memcpy(payload + 1, &ctx->filter_color, sizeof(rgba));
+		write_record(recording, RECORD_FILTER, payload, sizeof(payload));
+		recording->last_filter_type = ctx->filter_type;
+		recording->last_filter_color = ctx->filter_color;
+	}
+
+	recording->has_state = true;
+}
+
+/**
+ * @name	draw_recorder_clear
+ * @brief	records a clear of the whole context
+ * @param	ctx - (context_2d *) context being cleared
+ * @retval	NONE
+ */
+void draw_recorder_clear(context_2d *ctx) {
+	draw_recording *recording = draw_recorder_recording;
+	if (recording) {
+		record_state(recording, ctx, ctx->globalAlpha[ctx->mvp]);
+		write_record(recording, RECORD_CLEAR, NULL, 0);
+		recording->cleared = true;
+	}
+}
+
+/**
+ * @name	draw_recorder_image
+ * @brief	records a textured quad
+ * @param	ctx - (context_2d *) context being drawn to
+ * @param	tex - (texture_2d *) texture being drawn
+ * @param	src - (const rect_2d *) source rectangle on the texture
+ * @param	dest - (const rect_2d *) destination rectangle
+ * @param	alpha - (float) alpha of the draw, including the global alpha
+ * @param	composite_op - (int) composite operation of the draw
+ * @retval	NONE
+ */
+void draw_recorder_image(context_2d *ctx, texture_2d *tex, const rect_2d *src, const rect_2d *dest, float alpha, int composite_op) {
+	draw_recording *recording = draw_recorder_recording;
+	if (!recording) {
+		return;
+	}
+
+	int id = texture_id(recording, tex);
+	if (id < 0) {
+		recording->skipped_draws = true;
+		return;
+	}
+	record_state(recording, ctx, alpha);
+
+	unsigned char payload[2 + sizeof(int) + 2 * sizeof(rect_2d)];
+	unsigned short short_id = id;
+	memcpy(payload, &short_id, 2);
+	memcpy(payload + 2, &composite_op, sizeof(int));
+	memcpy(payload + 2 + sizeof(int), src, sizeof(rect_2d));
+	memcpy(payload + 2 + sizeof(int) + sizeof(rect_2d), dest, sizeof(rect_2d));
+	write_record(recording, RECORD_IMAGE, payload, sizeof(payload));
+}
+
+/**
+ * @name	draw_recorder_skip
+ * @brief	notes a draw that was skipped, such as one of a texture that has
+ *			not loaded yet
+ * @retval	NONE
+ */
+void draw_recorder_skip() {
+	if (draw_recorder_recording) {
+		draw_recorder_recording->skipped_draws = true;
+	}
+}
+
+/**
+ * @name	draw_recorder_fill_rect
+ * @brief	records a solid color rectangle
+ * @param	ctx - (context_2d *) context being drawn to
+ * @param	rect - (const rect_2d *) rectangle being filled
+ * @param	color - (const rgba *) fill color
+ * @param	composite_op - (int) composite operation of the draw
+ * @retval	NONE
+ */
+void draw_recorder_fill_rect(context_2d *ctx, const rect_2d *rect, const rgba *color, int composite_op) {
+	draw_recording *recording = draw_recorder_recording;
+	if (!recording) {
+		return;
+	}
+
+	record_state(recording, ctx, ctx->globalAlpha[ctx->mvp]);
+	unsigned char payload[sizeof(rect_2d) + sizeof(rgba) + sizeof(int)];
+	memcpy(payload, rect, sizeof(rect_2d));
+	memcpy(payload + sizeof(rect_2d), color, sizeof(rgba));
+	memcpy(payload + sizeof(rect_2d) + sizeof(rgba), &composite_op, sizeof(int));
+	write_record(recording, RECORD_FILL_RECT, payload, sizeof(payload));
+}
+
+/**
+ * @name	draw_recorder_clear_rect
+ * @brief	records a cleared rectangle
+ * @param	ctx - (context_2d *) context being drawn to
+ * @param	rect - (const rect_2d *) rectangle being cleared
+ * @retval	NONE
+ */
+void draw_recorder_clear_rect(context_2d *ctx, const rect_2d *rect) {
+	draw_recording *recording = draw_recorder_recording;
+	if (recording) {
+		record_state(recording, ctx, ctx->globalAlpha[ctx->mvp]);
+		write_record(recording, RECORD_CLEAR_RECT, rect, sizeof(rect_2d));
+	}
+}
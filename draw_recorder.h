@@ -0,0 +1,62 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+#ifndef DRAW_RECORDER_H
+#define DRAW_RECORDER_H
+
+#include "core/tealeaf_context.h"
+#include "core/texture_2d.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct draw_recording_t;
+typedef struct draw_recording_t draw_recording;
+
+// recording the draw calls are currently captured into, NULL when not recording
+extern draw_recording *draw_recorder_recording;
+
+draw_recording *draw_recording_new();
+void draw_recording_free(draw_recording *recording);
+void draw_recording_clear(draw_recording *recording);
+bool draw_recording_save(draw_recording *recording, const char *path);
+draw_recording *draw_recording_load(const char *path);
+void draw_recording_replay(draw_recording *recording);
+void draw_recording_replay_into(draw_recording *recording, context_2d *ctx, const matrix_2x3 *transform, float alpha_scale);
+bool draw_recording_is_local(draw_recording *recording, context_2d *ctx, const rect_2d *clip);
+bool draw_recording_is_complete(draw_recording *recording);
+int draw_recording_get_texture_count(draw_recording *recording);
+const char *draw_recording_get_texture(draw_recording *recording, int index, int *width, int *height, int *original_width, int *original_height, bool *is_canvas);
+size_t draw_recording_get_size(draw_recording *recording);
+
+void draw_recorder_start(draw_recording *recording);
+draw_recording *draw_recorder_stop();
+void draw_recorder_capture_frame(const char *path);
+void draw_recorder_frame_begin();
+void draw_recorder_frame_end();
+
+void draw_recorder_bind(context_2d *ctx);
+void draw_recorder_clear(context_2d *ctx);
+void draw_recorder_skip();
+void draw_recorder_image(context_2d *ctx, texture_2d *tex, const rect_2d *src, const rect_2d *dest, float alpha, int composite_op);
+void draw_recorder_fill_rect(context_2d *ctx, const rect_2d *rect, const rgba *color, int composite_op);
+void draw_recorder_clear_rect(context_2d *ctx, const rect_2d *rect);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DRAW_RECORDER_H
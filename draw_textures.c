@@ -21,42 +21,508 @@
 #include <sys/time.h>
 #include "core/tealeaf_context.h"
 #include "core/tealeaf_shaders.h"
+#include "core/gl_state.h"
 #include "core/log.h"
 #include "platform/gl.h"
 #include <math.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdlib.h>
 
 #define DRAW_TEXTURES_PROFILE 0
-#define MAX_BUFFER_SIZE 1024
+// sizes of the staging buffer in quads, it grows up to the max as frames need it.
+// 4 vertices per quad keeps every index of MAX_BUFFER_SIZE quads in a GLushort
+#define DEFAULT_BUFFER_SIZE 1024
+#define MAX_BUFFER_SIZE 16384
 
 
+bool use_multi_texture_batching = true;
+bool use_vertex_buffer_objects = true;
+bool use_software_clipping = true;
+
 static int lastName = -1;
 static int bufSize = 0;
-static float lastOpacity = 1;
 static int last_composite_op = 0;
-static int last_filter_type = 0;
-static rgba last_filter_color = {0, 0, 0, 0};
+static unsigned int last_shader = PRIMARY_SHADER;
+// textures referenced by the current batch, bound to units 0..bound_count-1
+static int bound_names[MAX_BATCH_TEXTURES];
+static int bound_count = 0;
+static draw_textures_stats stats;
+// scissor rect currently applied to gl, width < 0 when the scissor test is off
+static rect_2d scissor_rect = {0, 0, -1, -1};
+// clip of the last queued item
+static rect_2d last_clip = {0, 0, -1, -1};
+
+// point sprite batch, positions are in vertex space and the brush state is
+// shared by every queued point
+static GLfloat *points = NULL;
+static unsigned int point_count = 0;
+static unsigned int point_capacity = 0;
+static int point_name = -1;
+static float point_size = 0;
+static rgba point_color;
+
+/*
+ * Colors are sent per-vertex as normalized unsigned bytes so that opacity
+ * and filter changes between quads no longer need to break the batch.
+ * color is the premultiplied draw color, add_color is only read by the
+ * linear add shader.
+ */
+typedef struct vertex_color_t {
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+} vertex_color;
+
+typedef struct vertex_t {
+	float srcX;
+	float srcY;
+	float destX;
+	float destY;
+	vertex_color color;
+	vertex_color add_color;
+	// texture unit sampled by the multi-texture shaders
+	unsigned char tex_index;
+	unsigned char padding[3];
+} vertex;
+
+/*
+ * One quad, drawn as the indexed triangles (v1, v2, v3) and (v2, v4, v3):
+ *    v1 - v2
+ *     | / |
+ *    v3 - v4
+ */
 typedef struct bufobj_t {
-	float srcX1;
-	float srcY1;
-	float destX1;
-	float destY1;
-	float srcX2;
-	float srcY2;
-	float destX2;
-	float destY2;
-	float srcX3;
-	float srcY3;
-	float destX3;
-	float destY3;
+	vertex v1;
+	vertex v2;
+	vertex v3;
+	vertex v4;
 } bufobj;
 
-static bufobj buffer[MAX_BUFFER_SIZE];
+static bufobj *buffer = NULL;
+static int buffer_capacity = 0;
+// model view and destination of each queued quad, transformed in bulk at flush
+static matrix_2x3 *quad_model_views = NULL;
+static rect_2d *quad_dests = NULL;
+
+// static quad indices for buffer_capacity quads, uploaded to ibo in vbo mode
+static GLushort *indices = NULL;
+static GLuint ibo = 0;
+static int ibo_capacity = 0;
+
+// streaming vertex buffer, batches are appended at vbo_offset and the
+// storage is orphaned when it fills up so the driver never stalls on it
+static GLuint vbo = 0;
+static GLsizeiptr vbo_size = 0;
+static GLintptr vbo_offset = 0;
+
+/**
+ * @name	grow_buffer
+ * @brief	grows the staging and index buffers so they can hold at least the given number of quads
+ * @param	size - (int) required capacity in quads
+ * @retval	bool - (true | false) depending on whether the buffer can hold size quads
+ */
+static bool grow_buffer(int size) {
+	if (size <= buffer_capacity) {
+		return true;
+	} else if (size > MAX_BUFFER_SIZE) {
+		return false;
+	}
+
+	int capacity = buffer_capacity ? buffer_capacity : DEFAULT_BUFFER_SIZE;
+	while (capacity < size) {
+		capacity *= 2;
+	}
+	if (capacity > MAX_BUFFER_SIZE) {
+		capacity = MAX_BUFFER_SIZE;
+	}
+
+	bufobj *grown = (bufobj *)realloc(buffer, capacity * sizeof(bufobj));
+	GLushort *grown_indices = (GLushort *)realloc(indices, capacity * 6 * sizeof(GLushort));
+	matrix_2x3 *grown_model_views = (matrix_2x3 *)realloc(quad_model_views, capacity * sizeof(matrix_2x3));
+	rect_2d *grown_dests = (rect_2d *)realloc(quad_dests, capacity * sizeof(rect_2d));
+	if (grown) {
+		buffer = grown;
+	}
+	if (grown_indices) {
+		indices = grown_indices;
+	}
+	if (grown_model_views) {
+		quad_model_views = grown_model_views;
+	}
+	if (grown_dests) {
+		quad_dests = grown_dests;
+	}
+	if (!grown || !grown_indices || !grown_model_views || !grown_dests) {
+		LOG("{drawtex} WARNING: Unable to grow vertex buffer to %d quads", capacity);
+		return false;
+	}
+
+	int i;
+	for (i = buffer_capacity; i < capacity; i++) {
+		GLushort *quad = indices + 6 * i;
+		GLushort first = (GLushort)(4 * i);
+		quad[0] = first;
+		quad[1] = first + 1;
+		quad[2] = first + 2;
+		quad[3] = first + 1;
+		quad[4] = first + 3;
+		quad[5] = first + 2;
+	}
+
+	buffer_capacity = capacity;
+	return true;
+}
+
+/**
+ * @name	pack_component
+ * @brief	clamps a color component to [0, 1] and converts it to a byte
+ * @param	x - (float) color component
+ * @retval	unsigned char - the normalized byte value
+ */
+static inline unsigned char pack_component(float x) {
+	if (x <= 0) {
+		return 0;
+	} else if (x >= 1) {
+		return 255;
+	}
+
+	return (unsigned char)(x * 255 + 0.5f);
+}
+
+/**
+ * @name	pack_color
+ * @brief	packs the given color components into a vertex color
+ * @param	c - (vertex_color *) destination of the packed color
+ * @param	r - (float) red component
+ * @param	g - (float) green component
+ * @param	b - (float) blue component
+ * @param	a - (float) alpha component
+ * @retval	NONE
+ */
+static inline void pack_color(vertex_color *c, float r, float g, float b, float a) {
+	c->r = pack_component(r);
+	c->g = pack_component(g);
+	c->b = pack_component(b);
+	c->a = pack_component(a);
+}
+
+/**
+ * @name	batch_texture_slot
+ * @brief	finds the texture unit the given texture is bound to in the current batch
+ * @param	name - (int) gl texture id
+ * @retval	int - texture unit index, or -1 if the texture is not in the batch
+ */
+static inline int batch_texture_slot(int name) {
+	int i;
+	for (i = 0; i < bound_count; i++) {
+		if (bound_names[i] == name) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @name	rect_contains
+ * @brief	checks whether the outer rect fully contains the inner rect
+ * @param	outer - (const rect_2d *) containing rect
+ * @param	inner - (const rect_2d *) contained rect
+ * @retval	bool - (true | false) depending on whether inner lies within outer
+ */
+static inline bool rect_contains(const rect_2d *outer, const rect_2d *inner) {
+	return inner->x >= outer->x && inner->y >= outer->y &&
+	       inner->x + inner->width <= outer->x + outer->width &&
+	       inner->y + inner->height <= outer->y + outer->height;
+}
+
+/**
+ * @name	clip_to_vertex_space
+ * @brief	converts a clip rect from scissor coordinates to the coordinates
+ *			vertices are emitted in. The onscreen framebuffer has a flipped y-axis.
+ * @param	clip - (const rect_2d *) clip rect in scissor coordinates
+ * @param	out - (rect_2d *) clip rect in vertex coordinates
+ * @retval	NONE
+ */
+static inline void clip_to_vertex_space(const rect_2d *clip, rect_2d *out) {
+	tealeaf_canvas *canvas = tealeaf_canvas_get();
+	// snap the same way glScissor does so both clip paths agree
+	out->x = (int) clip->x;
+	out->y = (int) clip->y;
+	out->width = (int) clip->width;
+	out->height = (int) clip->height;
+
+	if (canvas->active_ctx && canvas->active_ctx->on_screen) {
+		out->y = canvas->framebuffer_height + canvas->framebuffer_offset_bottom - out->y - out->height;
+	}
+}
+
+/**
+ * @name	clip_axis_aligned
+ * @brief	clips a destination rect drawn with an axis-aligned model view against
+ *			the given clip, shrinking the source rect by the same proportion
+ * @param	model_view - (const matrix_2x3 *) axis-aligned model view
+ * @param	clip - (const rect_2d *) clip rect in vertex coordinates
+ * @param	src - (rect_2d *) source rect to adjust
+ * @param	dest - (rect_2d *) destination rect to adjust
+ * @retval	bool - (true | false) depending on whether anything is left to draw
+ */
+static bool clip_axis_aligned(const matrix_2x3 *model_view, const rect_2d *clip, rect_2d *src, rect_2d *dest) {
+	if (model_view->m00 == 0 || model_view->m11 == 0) {
+		return false;
+	}
+
+	// bring the clip into model space, where dest is axis-aligned as well
+	float x1 = (clip->x - model_view->m02) / model_view->m00;
+	float x2 = (clip->x + clip->width - model_view->m02) / model_view->m00;
+	float y1 = (clip->y - model_view->m12) / model_view->m11;
+	float y2 = (clip->y + clip->height - model_view->m12) / model_view->m11;
+	float min_x = x1 < x2 ? x1 : x2, max_x = x1 < x2 ? x2 : x1;
+	float min_y = y1 < y2 ? y1 : y2, max_y = y1 < y2 ? y2 : y1;
+
+	float left = dest->x > min_x ? dest->x : min_x;
+	float right = dest->x + dest->width < max_x ? dest->x + dest->width : max_x;
+	float top = dest->y > min_y ? dest->y : min_y;
+	float bottom = dest->y + dest->height < max_y ? dest->y + dest->height : max_y;
+
+	if (left >= right || top >= bottom) {
+		return false;
+	}
+
+	float sx = src->width / dest->width;
+	float sy = src->height / dest->height;
+	src->x += (left - dest->x) * sx;
+	src->y += (top - dest->y) * sy;
+	src->width = (right - left) * sx;
+	src->height = (bottom - top) * sy;
+	dest->x = left;
+	dest->y = top;
+	dest->width = right - left;
+	dest->height = bottom - top;
+	return true;
+}
+
+/**
+ * @name	stream_vertices
+ * @brief	appends vertex data to the stream vertex buffer object, orphaning
+ *			its storage when full, and leaves the buffer bound
+ * @param	data - (const void *) vertex data to upload
+ * @param	bytes - (GLsizeiptr) size of the data
+ * @retval	const char* - offset of the data in the buffer, to be used as an attribute pointer
+ */
+static const char *stream_vertices(const void *data, GLsizeiptr bytes) {
+	if (!vbo) {
+		GLTRACE(glGenBuffers(1, &vbo));
+	}
+	gl_state_bind_buffer(GL_ARRAY_BUFFER, vbo);
+	if (bytes > vbo_size) {
+		vbo_size = bytes > 2 * vbo_size ? bytes : 2 * vbo_size;
+		GLTRACE(glBufferData(GL_ARRAY_BUFFER, vbo_size, NULL, GL_STREAM_DRAW));
+		vbo_offset = 0;
+	} else if (vbo_offset + bytes > vbo_size) {
+		// orphan the storage still in use by queued draws
+		GLTRACE(glBufferData(GL_ARRAY_BUFFER, vbo_size, NULL, GL_STREAM_DRAW));
+		vbo_offset = 0;
+	}
+	GLTRACE(glBufferSubData(GL_ARRAY_BUFFER, vbo_offset, bytes, data));
+	const char *base = (const char *)(size_t)vbo_offset;
+	vbo_offset += bytes;
+	return base;
+}
+
+/**
+ * @name	flush_points
+ * @brief	draws every queued point sprite with a single draw call
+ * @retval	NONE
+ */
+static void flush_points() {
+	if (point_count == 0) {
+		return;
+	}
+
+	tealeaf_shader *shader = &global_shaders[DRAWING_SHADER];
+	tealeaf_shaders_bind(DRAWING_SHADER);
+	gl_state_active_texture(GL_TEXTURE0);
+	gl_state_bind_texture(point_name);
+	gl_state_blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	gl_state_texture_params(point_name, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	GLTRACE(glUniform1f(shader->point_size, point_size));
+	GLTRACE(glUniform4f(shader->draw_color, point_color.a * point_color.r, point_color.a * point_color.g, point_color.a * point_color.b, point_color.a));
+
+	const char *base = (const char *)points;
+	if (use_vertex_buffer_objects) {
+		base = stream_vertices(points, point_count * 2 * sizeof(GLfloat));
+	}
+	GLTRACE(glVertexAttribPointer(shader->vertex_coords, 2, GL_FLOAT, GL_FALSE, 0, base));
+	GLTRACE(glDrawArrays(GL_POINTS, 0, point_count));
+	stats.draw_calls++;
+	if (use_vertex_buffer_objects) {
+		gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	point_count = 0;
+}
+
+/**
+ * @name	normalize_composite_op
+ * @brief	maps composite operations that blend like source-over onto source_over
+ *			so they can share a batch
+ * @param	composite_op - (int) composite operation
+ * @retval	int - the composite operation to key the batch on
+ */
+static inline int normalize_composite_op(int composite_op) {
+	switch (composite_op) {
+		case source_atop:
+		case source_in:
+		case source_out:
+		case destination_atop:
+		case destination_in:
+		case destination_out:
+		case destination_over:
+			return composite_op;
+
+		default:
+			return source_over;
+	}
+}
+
+/**
+ * @name	queue_quad
+ * @brief	clips, culls and queues a textured quad, flushing first if the quad
+ *			cannot join the current batch
+ * @param	model_view - (const matrix_2x3 *) model view of the quad
+ * @param	name - (int) gl texture id
+ * @param	src_width - (int) width of the source texture
+ * @param	src_height - (int) height of the source texture
+ * @param	src - (rect_2d) source rectangle on the texture
+ * @param	dest - (rect_2d) destination rectangle to draw to
+ * @param	clip - (rect_2d) current clipping rectangle
+ * @param	color - (vertex_color) premultiplied draw color
+ * @param	add_color - (vertex_color) linear add color
+ * @param	linear_add - (bool) whether to draw with a linear add shader
+ * @param	composite_op - (int) composite operation to use for rendering
+ * @retval	NONE
+ */
+static void queue_quad(const matrix_2x3 *model_view, int name, int src_width, int src_height, rect_2d src, rect_2d dest, rect_2d clip, vertex_color color, vertex_color add_color, bool linear_add, int composite_op) {
+	// point sprites queued before the quad have to be drawn first
+	flush_points();
+
+	// clip axis-aligned quads on the cpu so clip changes do not require a new
+	// scissor rect, anything else relies on the exact gl scissor
+	bool clipped = clip.width >= 0;
+	bool soft_clipped = false;
+	rect_2d vertex_clip = {0, 0, 0, 0};
+	if (clipped) {
+		clip_to_vertex_space(&clip, &vertex_clip);
+	}
+
+	if (clipped && use_software_clipping && model_view->m01 == 0 && model_view->m10 == 0 && dest.width > 0 && dest.height > 0) {
+		if (!clip_axis_aligned(model_view, &vertex_clip, &src, &dest)) {
+			stats.culled_quads++;
+			return;
+		}
+		soft_clipped = true;
+	}
+
+	// drop quads whose bounds miss the framebuffer or the clip before they
+	// take up buffer space or break the batch. The corners themselves are
+	// transformed in bulk at flush, the bounds follow from the center and
+	// the transformed half extents.
+	float half_width = dest.width / 2, half_height = dest.height / 2;
+	float center_x, center_y;
+	matrix_2x3_multiply(model_view, dest.x + half_width, dest.y + half_height, &center_x, &center_y);
+	float extent_x = fabsf(model_view->m00 * half_width) + fabsf(model_view->m01 * half_height);
+	float extent_y = fabsf(model_view->m10 * half_width) + fabsf(model_view->m11 * half_height);
+	float min_x = center_x - extent_x, max_x = center_x + extent_x;
+	float min_y = center_y - extent_y, max_y = center_y + extent_y;
+	context_2d *ctx = tealeaf_canvas_get()->active_ctx;
+	if ((ctx && (max_x <= 0 || max_y <= 0 || min_x >= ctx->backing_width || min_y >= ctx->backing_height)) ||
+	        (clipped && !soft_clipped && (max_x <= vertex_clip.x || max_y <= vertex_clip.y ||
+	                                      min_x >= vertex_clip.x + vertex_clip.width || min_y >= vertex_clip.y + vertex_clip.height))) {
+		stats.culled_quads++;
+		return;
+	}
+
+	if (soft_clipped) {
+		// a scissor containing the clip does not touch what is left of the quad
+		if (scissor_rect.width >= 0 && !rect_contains(&scissor_rect, &clip)) {
+			rect_2d none = {0, 0, -1, -1};
+			draw_textures_apply_scissor(&none);
+		}
+	} else if (clipped) {
+		draw_textures_apply_scissor(&clip);
+	} else if (scissor_rect.width >= 0) {
+		draw_textures_apply_scissor(&clip);
+	}
+
+	if (!rect_2d_equals(&clip, &last_clip)) {
+		if (bufSize > 0) {
+			stats.scissor_flushes_avoided++;
+		}
+		last_clip = clip;
+	}
+
+	// a texture switch only breaks the batch once every texture unit is taken
+	bool multi_texture = use_multi_texture_batching && tealeaf_shaders_get_batch_texture_units() > 1;
+	int max_textures = multi_texture ? tealeaf_shaders_get_batch_texture_units() : 1;
+	unsigned int shader;
+	if (linear_add) {
+		shader = multi_texture ? LINEAR_ADD_MULTI_SHADER : LINEAR_ADD_SHADER;
+	} else {
+		shader = multi_texture ? PRIMARY_MULTI_SHADER : PRIMARY_SHADER;
+	}
+	composite_op = normalize_composite_op(composite_op);
+
+	int slot = batch_texture_slot(name);
+	if ((slot < 0 && bound_count >= max_textures) || !grow_buffer(bufSize + 1) || composite_op != last_composite_op || shader != last_shader) {
+		draw_textures_flush();
+		slot = -1;
+		last_composite_op = composite_op;
+		last_shader = shader;
+
+		if (!grow_buffer(bufSize + 1)) {
+			return;
+		}
+	} else if (name != lastName && bufSize > 0) {
+		stats.draw_calls_saved++;
+	}
+
+	if (slot < 0) {
+		slot = bound_count++;
+		bound_names[slot] = name;
+	}
+	lastName = name;
+
+	bufobj *o = buffer + bufSize++;
+	float sMin, tMin, sMax, tMax;
+	sMin = src.x / (float) src_width,
+	tMin = src.y / (float)src_height,
+	sMax = (src.x + src.width) / (float)src_width,
+	tMax = (src.y + src.height) / (float)src_height;
+
+	o->v1.srcX = sMin;
+	o->v1.srcY = tMin;
+	o->v2.srcX = sMax;
+	o->v2.srcY = tMin;
+	o->v3.srcX = sMin;
+	o->v3.srcY = tMax;
+	o->v4.srcX = sMax;
+	o->v4.srcY = tMax;
+	quad_model_views[bufSize - 1] = *model_view;
+	quad_dests[bufSize - 1] = dest;
+	o->v1.color = o->v2.color = o->v3.color = o->v4.color = color;
+	o->v1.add_color = o->v2.add_color = o->v3.add_color = o->v4.add_color = add_color;
+	o->v1.tex_index = o->v2.tex_index = o->v3.tex_index = o->v4.tex_index = slot;
+}
+
 /**
  * @name	draw_textures_item
  * @brief	takes the given options and queues a texture to be drawn.
  *			this may also trigger a draw_textures_flush if options warranting
  *			a flush are found.
- * @param	model_view - (matrix_3x3) currently used modelview
+ * @param	model_view - (matrix_2x3) currently used modelview
  * @param	name - (int) gl texture id
  * @param	src_width - (int) width of the source texture
  * @param	src_height - (int) height of the source texture
@@ -71,60 +537,122 @@ static bufobj buffer[MAX_BUFFER_SIZE];
  * @param	filter_type - (int) the type of filter being used currently
  * @retval	NONE
  */
-void draw_textures_item(const matrix_3x3 *model_view, int name, int src_width, int src_height, int orig_width, int orig_height, rect_2d src, rect_2d dest, rect_2d clip, float opacity, int composite_op, rgba *filter_color, int filter_type) {
+void draw_textures_item(const matrix_2x3 *model_view, int name, int src_width, int src_height, int orig_width, int orig_height, rect_2d src, rect_2d dest, rect_2d clip, float opacity, int composite_op, rgba *filter_color, int filter_type) {
 	//ignore this item if clip height is 0
 	if (clip.height == 0 || clip.width == 0) {
 		return;
 	}
 
-	if (name != lastName || bufSize + 2 >= MAX_BUFFER_SIZE || lastOpacity != opacity || composite_op != last_composite_op  || !rgba_equals(&last_filter_color, filter_color) || last_filter_type != filter_type) {
-		// TODO: PERFORMANCE: could send opacity to GPU too by interleaving a buffered color array
+	// fully transparent quads would be drawn with a zero color anyway
+	if (opacity <= 0) {
+		return;
+	}
+
+	// opacity and filter colors travel with the vertices, so only the
+	// texture, blending and shader program have to match the batch
+	vertex_color color, add_color;
+	bool linear_add = false;
+	pack_color(&add_color, 0, 0, 0, 0);
+
+	if (use_single_shader || filter_type == FILTER_NONE) {
+		pack_color(&color, opacity, opacity, opacity, opacity);
+	} else if (filter_type == FILTER_LINEAR_ADD) {
+		linear_add = true;
+		pack_color(&color, opacity, opacity, opacity, opacity);
+		pack_color(&add_color, filter_color->r * filter_color->a, filter_color->g * filter_color->a, filter_color->b * filter_color->a, 0);
+	} else if (filter_type == FILTER_MULTIPLY) {
+		pack_color(&color, filter_color->r * opacity, filter_color->g * opacity, filter_color->b * opacity, opacity);
+	} else {
+		pack_color(&color, opacity, opacity, opacity, opacity);
+	}
+
+	queue_quad(model_view, name, src_width, src_height, src, dest, clip, color, add_color, linear_add, composite_op);
+}
+
+/**
+ * @name	draw_textures_fill_rect
+ * @brief	queues a solid color rectangle, drawn from the white texel so that it
+ *			shares batches with textures
+ * @param	model_view - (const matrix_2x3 *) currently used modelview
+ * @param	white_tex - (int) gl id of a texture whose texels are all opaque white
+ * @param	rect - (rect_2d) rectangle to fill
+ * @param	clip - (rect_2d) current clipping rectangle
+ * @param	color - (const rgba *) color to fill with, alpha already includes the global alpha
+ * @param	composite_op - (int) composite operation to use for rendering
+ * @retval	NONE
+ */
+void draw_textures_fill_rect(const matrix_2x3 *model_view, int white_tex, rect_2d rect, rect_2d clip, const rgba *color, int composite_op) {
+	if (clip.height == 0 || clip.width == 0 || color->a <= 0) {
+		return;
+	}
+
+	vertex_color fill, add_color;
+	pack_color(&fill, color->r * color->a, color->g * color->a, color->b * color->a, color->a);
+	pack_color(&add_color, 0, 0, 0, 0);
+	rect_2d texel = {0, 0, 1, 1};
+	queue_quad(model_view, white_tex, 1, 1, texel, rect, clip, fill, add_color, false, composite_op);
+}
+
+/**
+ * @name	draw_textures_point_sprites
+ * @brief	queues point sprites every step_size pixels along a line segment.
+ *			Segments that share the brush texture, size and color are drawn
+ *			together at the next flush.
+ * @param	model_view - (const matrix_2x3 *) currently used modelview
+ * @param	name - (int) gl id of the brush texture
+ * @param	size - (float) size of each point sprite
+ * @param	step_size - (float) distance between point sprites
+ * @param	color - (const rgba *) brush color, alpha already includes the global alpha
+ * @param	x1 - (float) starting x-coordinate
+ * @param	y1 - (float) starting y-coordinate
+ * @param	x2 - (float) ending x-coordinate
+ * @param	y2 - (float) ending y-coordinate
+ * @retval	NONE
+ */
+void draw_textures_point_sprites(const matrix_2x3 *model_view, int name, float size, float step_size, const rgba *color, float x1, float y1, float x2, float y2) {
+	// quads queued before the points have to be drawn first
+	if (bufSize > 0) {
 		draw_textures_flush();
-		lastName = name;
-		lastOpacity = opacity;
-		last_composite_op = composite_op;
-		last_filter_color.r = filter_color->r;
-		last_filter_color.g = filter_color->g;
-		last_filter_color.b = filter_color->b;
-		last_filter_color.a = filter_color->a;
-		last_filter_type = filter_type;
 	}
 
-	bufSize += 2;
-	bufobj *o = buffer + bufSize - 2;
-	bufobj *o2 = o + 1;
-	float sMin, tMin, sMax, tMax;
-	sMin = src.x / (float) src_width,
-	tMin = src.y / (float)src_height,
-	sMax = (src.x + src.width) / (float)src_width,
-	tMax = (src.y + src.height) / (float)src_height;
+	if (point_count > 0 && (point_name != name || point_size != size || point_color.r != color->r ||
+	                        point_color.g != color->g || point_color.b != color->b || point_color.a != color->a)) {
+		flush_points();
+	}
+	point_name = name;
+	point_size = size;
+	point_color = *color;
 
-	o->srcX1 = sMin;
-	o->srcY1 = tMax;
-	o->srcX2 = sMax;
-	o->srcY2 = tMax;
-	o->srcX3 = sMin;
-	o->srcY3 = tMin;
-	o2->srcX1 = sMax;
-	o2->srcY1 = tMax;
-	o2->srcX2 = sMax;
-	o2->srcY2 = tMin;
-	o2->srcX3 = sMin;
-	o2->srcY3 = tMin;
-	float x1, y1, x2, y2, x3, y3, x4, y4;
-	matrix_3x3_multiply(model_view, &dest, &x1, &y1, &x2, &y2, &x3, &y3, &x4, &y4);
-	o->destX1 = x4;
-	o->destY1 = y4;
-	o->destX2 = x3;
-	o->destY2 = y3;
-	o->destX3 =  x1;
-	o->destY3 = y1;
-	o2->destX1 = x3;
-	o2->destY1 = y3;
-	o2->destX2 = x2;
-	o2->destY2 = y2;
-	o2->destX3 = x1;
-	o2->destY3 = y1;
+	matrix_2x3_multiply_m_f_f_f_f(model_view, x1, y1, &x1, &y1);
+	matrix_2x3_multiply_m_f_f_f_f(model_view, x2, y2, &x2, &y2);
+
+	// Add points to the buffer so there are drawing points every X pixels
+	unsigned int count = ceilf(sqrtf((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1)) / step_size);
+
+	if (count < 1) {
+		count = 1;
+	}
+
+	if (point_count + count > point_capacity) {
+		unsigned int capacity = point_capacity ? point_capacity : 64;
+		while (capacity < point_count + count) {
+			capacity *= 2;
+		}
+		GLfloat *grown = (GLfloat *) realloc(points, capacity * 2 * sizeof(GLfloat));
+		if (!grown) {
+			LOG("{drawtex} WARNING: Unable to grow the point sprite buffer to %u points", capacity);
+			return;
+		}
+		points = grown;
+		point_capacity = capacity;
+	}
+
+	unsigned int i;
+	for (i = 0; i < count; ++i) {
+		points[2 * point_count + 0] = x1 + (x2 - x1) * ((GLfloat)i / (GLfloat)count);
+		points[2 * point_count + 1] = y1 + (y2 - y1) * ((GLfloat)i / (GLfloat)count);
+		point_count += 1;
+	}
 }
 
 #if DRAW_TEXTURES_PROFILE
@@ -137,107 +665,205 @@ struct timeval lastFlush, prevTime, now;
  * @retval	NONE
  */
 void draw_textures_flush() {
+	// at most one of the point and quad batches has anything queued
+	flush_points();
+
 	if (bufSize <= 0) {
 		return;
 	}
 
-	if (lastOpacity > 0) {
-		int stride = sizeof(float) * 4;
-		int sfactor, dfactor;
-
-		switch (last_composite_op) {
-			case source_atop:
-				sfactor = GL_DST_ALPHA;
-				dfactor = GL_ONE_MINUS_SRC_ALPHA;
-				break;
-
-			case source_in:
-				sfactor = GL_DST_ALPHA;
-				dfactor = GL_ZERO;
-				break;
-
-			case source_out:
-				sfactor = GL_ONE_MINUS_DST_ALPHA;
-				dfactor = GL_ZERO;
-				break;
-
-			case source_over:
-				sfactor = GL_ONE;
-				dfactor = GL_ONE_MINUS_SRC_ALPHA;
-				break;
-
-			case destination_atop:
-				sfactor = GL_DST_ALPHA;
-				dfactor = GL_SRC_ALPHA;
-				break;
-
-			case destination_in:
-				sfactor = GL_ZERO;
-				dfactor = GL_SRC_ALPHA;
-				break;
-
-			case destination_out:
-				sfactor = GL_ONE_MINUS_SRC_ALPHA;
-				dfactor = GL_ONE_MINUS_SRC_ALPHA;
-				break;
-
-			case destination_over:
-				sfactor = GL_DST_ALPHA;
-				dfactor = GL_SRC_ALPHA;
-				break;
-
-			case lighter:
-			case x_or:
-			case copy:
-			default:
-				sfactor = GL_ONE;
-				dfactor = GL_ONE_MINUS_SRC_ALPHA;
-				break;
-		}
+	int stride = sizeof(vertex);
+	int sfactor, dfactor;
+
+	switch (last_composite_op) {
+		case source_atop:
+			sfactor = GL_DST_ALPHA;
+			dfactor = GL_ONE_MINUS_SRC_ALPHA;
+			break;
+
+		case source_in:
+			sfactor = GL_DST_ALPHA;
+			dfactor = GL_ZERO;
+			break;
 
-		GLTRACE(glBlendFunc(sfactor, dfactor));
-		if (use_single_shader) {
-			tealeaf_shaders_bind(PRIMARY_SHADER);
-			GLTRACE(glUniform4f(global_shaders[current_shader].draw_color, lastOpacity, lastOpacity, lastOpacity, lastOpacity));
-		} else {
-			//TODO: implement filters using filter_type on views properly
-			if (last_filter_type == FILTER_NONE) {
-				tealeaf_shaders_bind(PRIMARY_SHADER);
-				GLTRACE(glUniform4f(global_shaders[current_shader].draw_color, lastOpacity, lastOpacity, lastOpacity, lastOpacity));
-			} else if (last_filter_type == FILTER_LINEAR_ADD) {
-				float r = last_filter_color.r * last_filter_color.a;
-				float g = last_filter_color.g * last_filter_color.a;
-				float b = last_filter_color.b * last_filter_color.a;
-				tealeaf_shaders_bind(LINEAR_ADD_SHADER);
-				GLTRACE(glUniform4f(global_shaders[current_shader].add_color, r, g, b, 0));
-				GLTRACE(glUniform4f(global_shaders[current_shader].draw_color, lastOpacity, lastOpacity, lastOpacity, lastOpacity));
-			} else if (last_filter_type == FILTER_MULTIPLY) {
-				tealeaf_shaders_bind(PRIMARY_SHADER);
-				GLTRACE(glUniform4f(global_shaders[current_shader].draw_color, last_filter_color.r * lastOpacity, last_filter_color.g * lastOpacity, last_filter_color.b * lastOpacity, lastOpacity));
-			}
+		case source_out:
+			sfactor = GL_ONE_MINUS_DST_ALPHA;
+			dfactor = GL_ZERO;
+			break;
+
+		case source_over:
+			sfactor = GL_ONE;
+			dfactor = GL_ONE_MINUS_SRC_ALPHA;
+			break;
+
+		case destination_atop:
+			sfactor = GL_DST_ALPHA;
+			dfactor = GL_SRC_ALPHA;
+			break;
+
+		case destination_in:
+			sfactor = GL_ZERO;
+			dfactor = GL_SRC_ALPHA;
+			break;
+
+		case destination_out:
+			sfactor = GL_ONE_MINUS_SRC_ALPHA;
+			dfactor = GL_ONE_MINUS_SRC_ALPHA;
+			break;
+
+		case destination_over:
+			sfactor = GL_DST_ALPHA;
+			dfactor = GL_SRC_ALPHA;
+			break;
+
+		case lighter:
+		case x_or:
+		case copy:
+		default:
+			sfactor = GL_ONE;
+			dfactor = GL_ONE_MINUS_SRC_ALPHA;
+			break;
+	}
+
+	gl_state_blend_func(sfactor, dfactor);
+	tealeaf_shaders_bind(last_shader);
+	tealeaf_shader *shader = &global_shaders[last_shader];
+
+	// bind the batch textures in reverse so unit 0 is left active
+	int i;
+	for (i = bound_count - 1; i >= 0; i--) {
+		gl_state_active_texture(GL_TEXTURE0 + i);
+		gl_state_bind_texture(bound_names[i]);
+		gl_state_texture_params(bound_names[i], GL_LINEAR, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	}
+	// fill in the vertex positions of every queued quad
+	matrix_2x3_transform_quads(quad_model_views, quad_dests, bufSize, &buffer[0].v1.destX, sizeof(vertex));
+
+	// attribute and index pointers are offsets into the buffer objects or
+	// addresses in client memory
+	const char *base = (const char *)buffer;
+	const GLushort *index_base = indices;
+	if (use_vertex_buffer_objects) {
+		if (!ibo) {
+			GLTRACE(glGenBuffers(1, &ibo));
 		}
+		gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+		if (ibo_capacity < buffer_capacity) {
+			GLTRACE(glBufferData(GL_ELEMENT_ARRAY_BUFFER, buffer_capacity * 6 * sizeof(GLushort), indices, GL_STATIC_DRAW));
+			ibo_capacity = buffer_capacity;
+		}
+		index_base = NULL;
+
+		base = stream_vertices(buffer, bufSize * sizeof(bufobj));
+	}
 
-		GLTRACE(glActiveTexture(GL_TEXTURE0));
-		GLTRACE(glBindTexture(GL_TEXTURE_2D, lastName));
-		GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-		GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
-		GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-		GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-		GLTRACE(glVertexAttribPointer(global_shaders[current_shader].vertex_coords, 2, GL_FLOAT, GL_FALSE, stride, ((float *) buffer) + 2));
-		//TexCoord0, XY (Also called ST. Also called UV), FLOAT.
-		GLTRACE(glVertexAttribPointer(global_shaders[current_shader].tex_coords, 2, GL_FLOAT, GL_FALSE, stride, buffer));
+	GLTRACE(glVertexAttribPointer(shader->vertex_coords, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(vertex, destX)));
+	//TexCoord0, XY (Also called ST. Also called UV), FLOAT.
+	GLTRACE(glVertexAttribPointer(shader->tex_coords, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(vertex, srcX)));
+	//Premultiplied draw color, RGBA, normalized UNSIGNED_BYTE.
+	GLTRACE(glVertexAttribPointer(shader->vertex_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + offsetof(vertex, color)));
+	if (shader->vertex_add_color != -1) {
+		GLTRACE(glVertexAttribPointer(shader->vertex_add_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + offsetof(vertex, add_color)));
+	}
+	//Texture unit index, UNSIGNED_BYTE read as a float.
+	if (shader->tex_index != -1) {
+		GLTRACE(glVertexAttribPointer(shader->tex_index, 1, GL_UNSIGNED_BYTE, GL_FALSE, stride, base + offsetof(vertex, tex_index)));
+	}
 #if DRAW_TEXTURES_PROFILE
-		gettimeofday(&prevTime, NULL);
+	gettimeofday(&prevTime, NULL);
 #endif
-		GLTRACE(glDrawArrays(GL_TRIANGLES, 0, 3 * bufSize));
+	GLTRACE(glDrawElements(GL_TRIANGLES, 6 * bufSize, GL_UNSIGNED_SHORT, index_base));
+	stats.draw_calls++;
+	if (use_vertex_buffer_objects) {
+		// the other draw paths use client-side arrays
+		gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
+		gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
 #if DRAW_TEXTURES_PROFILE
-		gettimeofday(&now, NULL);
-		LOG("{drawtex} Flush: %d %d %ld %ld\n", bufSize / 2, lastName,
-		    (now.tv_usec - prevTime.tv_usec),
-		    (now.tv_usec - lastFlush.tv_usec));
-		lastFlush = now;
+	gettimeofday(&now, NULL);
+	LOG("{drawtex} Flush: %d %d (%d textures) %ld %ld\n", bufSize, lastName, bound_count,
+	    (now.tv_usec - prevTime.tv_usec),
+	    (now.tv_usec - lastFlush.tv_usec));
+	lastFlush = now;
 #endif
+
+	bufSize = 0;
+	bound_count = 0;
+}
+
+/**
+ * @name	draw_textures_apply_scissor
+ * @brief	sets the gl scissor test to the given clip, flushing queued textures
+ *			if it changes. Draws that bypass draw_textures_item must call this
+ *			before drawing.
+ * @param	clip - (const rect_2d *) clip rect in scissor coordinates, a negative
+ *			width disables the scissor test
+ * @retval	NONE
+ */
+void draw_textures_apply_scissor(const rect_2d *clip) {
+	if (clip->width < 0) {
+		if (scissor_rect.width < 0) {
+			return;
+		}
+
+		draw_textures_flush();
+		stats.scissor_flushes++;
+		scissor_rect.x = scissor_rect.y = 0;
+		scissor_rect.width = scissor_rect.height = -1;
+		gl_state_disable(GL_SCISSOR_TEST);
+		return;
+	}
+
+	if (rect_2d_equals(&scissor_rect, clip)) {
+		return;
 	}
 
+	draw_textures_flush();
+	stats.scissor_flushes++;
+	gl_state_enable(GL_SCISSOR_TEST);
+	scissor_rect = *clip;
+	gl_state_scissor((int) clip->x, (int) clip->y, (int) clip->width, (int) clip->height);
+}
+
+/**
+ * @name	draw_textures_init
+ * @brief	allocates the staging buffer and forgets gl objects from a previous context
+ * @retval	NONE
+ */
+void draw_textures_init() {
 	bufSize = 0;
+	bound_count = 0;
+	lastName = -1;
+	grow_buffer(DEFAULT_BUFFER_SIZE);
+	point_count = 0;
+
+	scissor_rect.x = scissor_rect.y = 0;
+	scissor_rect.width = scissor_rect.height = -1;
+	last_clip = scissor_rect;
+	gl_state_disable(GL_SCISSOR_TEST);
+
+	// buffers from a lost context are already gone, do not delete them
+	vbo = 0;
+	vbo_size = 0;
+	vbo_offset = 0;
+	ibo = 0;
+	ibo_capacity = 0;
+}
+
+/**
+ * @name	draw_textures_get_stats
+ * @brief	gets the draw call counters collected since the last reset
+ * @retval	draw_textures_stats* - pointer to the counters
+ */
+draw_textures_stats *draw_textures_get_stats() {
+	return &stats;
+}
+
+/**
+ * @name	draw_textures_reset_stats
+ * @brief	zeroes the draw call counters
+ * @retval	NONE
+ */
+void draw_textures_reset_stats() {
+	memset(&stats, 0, sizeof(stats));
 }
@@ -23,9 +23,31 @@
 extern "C" {
 #endif
 
+typedef struct draw_textures_stats_t {
+	unsigned int draw_calls;
+	// texture switches that were batched instead of flushed
+	unsigned int draw_calls_saved;
+	unsigned int scissor_flushes;
+	// clip changes that were batched instead of flushed
+	unsigned int scissor_flushes_avoided;
+	// quads dropped for lying outside the framebuffer or clip
+	unsigned int culled_quads;
+} draw_textures_stats;
+
+extern bool use_multi_texture_batching;
+// stream batches through a vertex buffer object instead of client-side arrays
+extern bool use_vertex_buffer_objects;
+// clip axis-aligned quads on the cpu instead of with the gl scissor
+extern bool use_software_clipping;
+
 void draw_textures_flush();
-void draw_textures_item(const matrix_3x3 *model_view, int name, int src_width, int src_height, int orig_width, int orig_height, rect_2d src, rect_2d dest, rect_2d clip, float opacity, int composite_op, rgba *filter_color, int filter_type);
+void draw_textures_item(const matrix_2x3 *model_view, int name, int src_width, int src_height, int orig_width, int orig_height, rect_2d src, rect_2d dest, rect_2d clip, float opacity, int composite_op, rgba *filter_color, int filter_type);
+void draw_textures_fill_rect(const matrix_2x3 *model_view, int white_tex, rect_2d rect, rect_2d clip, const rgba *color, int composite_op);
+void draw_textures_point_sprites(const matrix_2x3 *model_view, int name, float size, float step_size, const rgba *color, float x1, float y1, float x2, float y2);
 void draw_textures_init();
+void draw_textures_apply_scissor(const rect_2d *clip);
+draw_textures_stats *draw_textures_get_stats();
+void draw_textures_reset_stats();
 
 #ifdef __cplusplus
 }
@@ -133,6 +133,138 @@ void matrix_3x3_multiply_m_f_f_f_f(const matrix_3x3 *a, float x, float y, float
 #endif
 }
 
+/**
+ * @name	matrix_3x3_multiply_m_m_m
+ * @brief	multiplies two matrices so that b is applied before a, the same as
+ *			applying the transforms of b to a one after the other
+ * @param	a - (const matrix_3x3 *) outer matrix
+ * @param	b - (const matrix_3x3 *) inner matrix
+ * @param	dest - (matrix_3x3 *) destination of the product, may be a or b
+ * @retval	NONE
+ */
+void matrix_3x3_multiply_m_m_m(const matrix_3x3 *a, const matrix_3x3 *b, matrix_3x3 *dest) {
+	matrix_3x3 r;
+#ifdef MATRIX_3x3_ALLOW_SKEW
+	r.m00 = a->m00 * b->m00 + a->m01 * b->m10 + a->m02 * b->m20;
+	r.m01 = a->m00 * b->m01 + a->m01 * b->m11 + a->m02 * b->m21;
+	r.m02 = a->m00 * b->m02 + a->m01 * b->m12 + a->m02 * b->m22;
+	r.m10 = a->m10 * b->m00 + a->m11 * b->m10 + a->m12 * b->m20;
+	r.m11 = a->m10 * b->m01 + a->m11 * b->m11 + a->m12 * b->m21;
+	r.m12 = a->m10 * b->m02 + a->m11 * b->m12 + a->m12 * b->m22;
+	r.m20 = a->m20 * b->m00 + a->m21 * b->m10 + a->m22 * b->m20;
+	r.m21 = a->m20 * b->m01 + a->m21 * b->m11 + a->m22 * b->m21;
+	r.m22 = a->m20 * b->m02 + a->m21 * b->m12 + a->m22 * b->m22;
+#else
+	//without skewing the bottom rows are 0 0 1
+	r.m00 = a->m00 * b->m00 + a->m01 * b->m10;
+	r.m01 = a->m00 * b->m01 + a->m01 * b->m11;
+	r.m02 = a->m00 * b->m02 + a->m01 * b->m12 + a->m02;
+	r.m10 = a->m10 * b->m00 + a->m11 * b->m10;
+	r.m11 = a->m10 * b->m01 + a->m11 * b->m11;
+	r.m12 = a->m10 * b->m02 + a->m11 * b->m12 + a->m12;
+	r.m20 = a->m20;
+	r.m21 = a->m21;
+	r.m22 = a->m22;
+#endif
+	*dest = r;
+}
+
+//2x3 Matrix Functions
+
+//Rotate matrix a by the given angle
+void matrix_2x3_rotate(matrix_2x3 *a, float angle) {
+	float c = cos(angle);
+	float s = sin(angle);
+	float t0, t1;
+
+	t0 = a->m00; t1 = a->m01;
+	a->m00 = c * t0 + s * t1;
+	a->m01 = c * t1 - s * t0;
+
+	t0 = a->m10; t1 = a->m11;
+	a->m10 = c * t0 + s * t1;
+	a->m11 = c * t1 - s * t0;
+}
+
+/**
+ * @name	matrix_2x3_multiply_m_m_m
+ * @brief	multiplies two affine matrices so that b is applied before a
+ * @param	a - (const matrix_2x3 *) outer matrix
+ * @param	b - (const matrix_2x3 *) inner matrix
+ * @param	dest - (matrix_2x3 *) destination of the product, may be a or b
+ * @retval	NONE
+ */
+void matrix_2x3_multiply_m_m_m(const matrix_2x3 *a, const matrix_2x3 *b, matrix_2x3 *dest) {
+	matrix_2x3 r;
+	r.m00 = a->m00 * b->m00 + a->m01 * b->m10;
+	r.m01 = a->m00 * b->m01 + a->m01 * b->m11;
+	r.m02 = a->m00 * b->m02 + a->m01 * b->m12 + a->m02;
+	r.m10 = a->m10 * b->m00 + a->m11 * b->m10;
+	r.m11 = a->m10 * b->m01 + a->m11 * b->m11;
+	r.m12 = a->m10 * b->m02 + a->m11 * b->m12 + a->m12;
+	*dest = r;
+}
+
+/**
+ * @name	matrix_2x3_invert
+ * @brief	inverts an affine matrix
+ * @param	a - (const matrix_2x3 *) matrix to invert
+ * @param	dest - (matrix_2x3 *) destination of the inverse, may be a
+ * @retval	bool - false if the matrix is singular and dest was left untouched
+ */
+bool matrix_2x3_invert(const matrix_2x3 *a, matrix_2x3 *dest) {
+	float det = a->m00 * a->m11 - a->m01 * a->m10;
+	if (det == 0) {
+		return false;
+	}
+
+	matrix_2x3 r;
+	r.m00 = a->m11 / det;
+	r.m01 = -a->m01 / det;
+	r.m10 = -a->m10 / det;
+	r.m11 = a->m00 / det;
+	r.m02 = -(r.m00 * a->m02 + r.m01 * a->m12);
+	r.m12 = -(r.m10 * a->m02 + r.m11 * a->m12);
+	*dest = r;
+	return true;
+}
+
+/**
+ * @name	matrix_2x3_transform_quads
+ * @brief	transforms the corners of many rectangles by their model views, writing
+ *			them out as a strided vertex stream. Each quad produces 4 vertices in
+ *			the order top left, top right, bottom left, bottom right.
+ * @param	model_views - (const matrix_2x3 *) one model view per rectangle
+ * @param	rects - (const rect_2d *) rectangles to transform
+ * @param	count - (unsigned int) number of rectangles
+ * @param	out - (float *) where the x coordinate of the first vertex is written, y follows it
+ * @param	stride - (size_t) distance in bytes between consecutive vertices
+ * @retval	NONE
+ */
+void matrix_2x3_transform_quads(const matrix_2x3 *model_views, const rect_2d *rects, unsigned int count, float *out, size_t stride) {
+	char *dest = (char *) out;
+	unsigned int i;
+	for (i = 0; i < count; i++) {
+		// the corners are computed into locals so that the stores to the
+		// vertex stream, which may alias the inputs, come last
+		float x1, y1, x2, y2, x3, y3, x4, y4;
+		matrix_2x3_multiply(&model_views[i], &rects[i], &x1, &y1, &x2, &y2, &x3, &y3, &x4, &y4);
+		float *tl = (float *) dest;
+		float *tr = (float *)(dest + stride);
+		float *bl = (float *)(dest + 2 * stride);
+		float *br = (float *)(dest + 3 * stride);
+		tl[0] = x1;
+		tl[1] = y1;
+		tr[0] = x2;
+		tr[1] = y2;
+		bl[0] = x4;
+		bl[1] = y4;
+		br[0] = x3;
+		br[1] = y3;
+		dest += 4 * stride;
+	}
+}
+
 //4x4 Matrix Functions
 
 #define O(y,x) (y + (x<<2))
@@ -156,7 +156,7 @@ __attribute__((unused)) static inline bool rect_2d_equals(const rect_2d *a, cons
     matrix_3x3_multiply_m_f_f_f_f(m, x, y, x2, y2)
 
 #define matrix_3x3_multiply3(a, b, dest) \
-    maxtrix_3x3_multiply_m_m_m(a, b, dest)
+    matrix_3x3_multiply_m_m_m(a, b, dest)
 
 #define matrix_3x3_multiply10(a, r, rx1, ry1, rx2, ry2, rx3, ry3, rx4, ry5) \
     matrix_3x3_multiply_m_r_f_f_f_f_f_f_f_f(a, r, rx1, ry1, rx2, ry2, rx3, ry3, rx4, ry5)
@@ -185,6 +185,7 @@ __attribute__((unused)) static void inline matrix_3x3_identity(matrix_3x3 *a) {
 }
 
 void matrix_3x3_multiply_m_f_f_f_f(const matrix_3x3 *a, float x, float y, float *x2, float *y2);
+void matrix_3x3_multiply_m_m_m(const matrix_3x3 *a, const matrix_3x3 *b, matrix_3x3 *dest);
 
 __attribute__((unused))static inline void matrix_3x3_multiply_m_r_f_f_f_f_f_f_f_f(const matrix_3x3 *a, const rect_2d *rect, float *rx1, float *ry1,float *rx2, float *ry2,float *rx3, float *ry3,float *rx4, float *ry4) {
 #ifdef MATRIX_3x3_ALLOW_SKEW
@@ -221,5 +222,83 @@ __attribute__((unused)) static inline void matrix_3x3_multiply_m_r_r(const matri
 	matrix_3x3_multiply(matrix, in->x4, in->y4, &out->x3, &out->y3);
 }
 
+//2x3 matrix functions
+
+//an affine transform, the top two rows of a matrix_3x3 whose bottom row is 0 0 1
+typedef struct matrix_2x3_t {
+	float m00, m01, m02,
+	      m10, m11, m12;
+} matrix_2x3;
+
+#define matrix_2x3_multiply(...) \
+    matrix_2x3_multiply_(PP_NARG(__VA_ARGS__))(__VA_ARGS__)
+#define matrix_2x3_multiply_(nargs) \
+    matrix_2x3_multiply__(nargs)
+#define matrix_2x3_multiply__(nargs) \
+    matrix_2x3_multiply ## nargs
+
+#define matrix_2x3_multiply5(m, x, y, x2, y2) \
+    matrix_2x3_multiply_m_f_f_f_f(m, x, y, x2, y2)
+
+#define matrix_2x3_multiply3(a, b, dest) \
+    matrix_2x3_multiply_m_m_m(a, b, dest)
+
+#define matrix_2x3_multiply10(a, r, rx1, ry1, rx2, ry2, rx3, ry3, rx4, ry5) \
+    matrix_2x3_multiply_m_r_f_f_f_f_f_f_f_f(a, r, rx1, ry1, rx2, ry2, rx3, ry3, rx4, ry5)
+
+void matrix_2x3_rotate(matrix_2x3 *a, float angle);
+void matrix_2x3_multiply_m_m_m(const matrix_2x3 *a, const matrix_2x3 *b, matrix_2x3 *dest);
+bool matrix_2x3_invert(const matrix_2x3 *a, matrix_2x3 *dest);
+void matrix_2x3_transform_quads(const matrix_2x3 *model_views, const rect_2d *rects, unsigned int count, float *out, size_t stride);
+
+__attribute__((unused)) static inline void matrix_2x3_identity(matrix_2x3 *a) {
+	a->m00 = 1;
+	a->m01 = 0;
+	a->m02 = 0;
+	a->m10 = 0;
+	a->m11 = 1;
+	a->m12 = 0;
+}
+
+//add x,y rotated to the translation components
+__attribute__((unused)) static inline void matrix_2x3_translate(matrix_2x3 *a, float x, float y) {
+	a->m02 += x * a->m00 + y * a->m01;
+	a->m12 += x * a->m10 + y * a->m11;
+}
+
+//multiply the first column by x and the second by y
+__attribute__((unused)) static inline void matrix_2x3_scale(matrix_2x3 *a, float x, float y) {
+	a->m00 *= x;
+	a->m10 *= x;
+	a->m01 *= y;
+	a->m11 *= y;
+}
+
+__attribute__((unused)) static inline void matrix_2x3_multiply_m_f_f_f_f(const matrix_2x3 *a, float x, float y, float *x2, float *y2) {
+	float tx = x * a->m00 + y * a->m01 + a->m02;
+	*y2 = x * a->m10 + y * a->m11 + a->m12;
+	*x2 = tx;
+}
+
+//corners come out as top left, top right, bottom right, bottom left
+__attribute__((unused)) static inline void matrix_2x3_multiply_m_r_f_f_f_f_f_f_f_f(const matrix_2x3 *a, const rect_2d *rect, float *rx1, float *ry1, float *rx2, float *ry2, float *rx3, float *ry3, float *rx4, float *ry4) {
+	matrix_2x3_multiply(a, rect->x, rect->y, rx1, ry1);
+	*rx4 = a->m01 * rect->height;
+	*ry4 = a->m11 * rect->height;
+	*rx2 = *rx1 + a->m00 * rect->width;
+	*ry2 = *ry1 + a->m10 * rect->width;
+	*rx3 = *rx2 + *rx4;
+	*ry3 = *ry2 + *ry4;
+	*rx4 += *rx1;
+	*ry4 += *ry1;
+}
+
+__attribute__((unused)) static inline void matrix_2x3_multiply_m_r_r(const matrix_2x3 *matrix, const rect_2d_vertices *in, rect_2d_vertices *out) {
+	matrix_2x3_multiply(matrix, in->x1, in->y1, &out->x1, &out->y1);
+	matrix_2x3_multiply(matrix, in->x2, in->y2, &out->x2, &out->y2);
+	matrix_2x3_multiply(matrix, in->x3, in->y3, &out->x4, &out->y4);
+	matrix_2x3_multiply(matrix, in->x4, in->y4, &out->x3, &out->y3);
+}
+
 
 #endif // MATRIX_H
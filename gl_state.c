@@ -0,0 +1,340 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+/**
+ * @file	 gl_state.c
+ * @brief	shadows the gl state set by the renderer and skips calls that would
+ *			not change it. Anything that changes gl state behind these functions
+ *			must call gl_state_invalidate_bindings (or gl_state_reset after a
+ *			context loss) so the shadow does not go stale.
+ */
+#include "core/gl_state.h"
+#include "core/deps/uthash/uthash.h"
+#include "core/log.h"
+#include <stdlib.h>
+
+// marks shadowed state as unknown, forcing the next call through
+#define UNKNOWN -1
+
+typedef struct texture_params_t {
+	GLuint name;
+	GLint min_filter;
+	GLint mag_filter;
+	GLint wrap_s;
+	GLint wrap_t;
+	UT_hash_handle hh;
+} texture_params;
+
+static GLint blend_sfactor = UNKNOWN;
+static GLint blend_dfactor = UNKNOWN;
+static int blend_enabled = UNKNOWN;
+static int scissor_enabled = UNKNOWN;
+static GLint scissor_box[4] = {UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN};
+static GLint program = UNKNOWN;
+static GLint active_unit = UNKNOWN;
+static GLint bound_textures[GL_STATE_TEXTURE_UNITS];
+static GLint array_buffer = UNKNOWN;
+static GLint element_array_buffer = UNKNOWN;
+static texture_params *params_by_name = NULL;
+static unsigned int suppressed_calls = 0;
+
+/**
+ * @name	gl_state_invalidate_bindings
+ * @brief	marks all shadowed bindings and server state as unknown, keeping the
+ *			per-texture sampler parameters
+ * @retval	NONE
+ */
+void gl_state_invalidate_bindings() {
+	int i;
+	blend_sfactor = blend_dfactor = UNKNOWN;
+	blend_enabled = scissor_enabled = UNKNOWN;
+	for (i = 0; i < 4; i++) {
+		scissor_box[i] = UNKNOWN;
+	}
+	program = UNKNOWN;
+	active_unit = UNKNOWN;
+	for (i = 0; i < GL_STATE_TEXTURE_UNITS; i++) {
+		bound_textures[i] = UNKNOWN;
+	}
+	array_buffer = element_array_buffer = UNKNOWN;
+}
+
+/**
+ * @name	gl_state_reset
+ * @brief	forgets all shadowed state, to be called when a gl context is created
+ * @retval	NONE
+ */
+void gl_state_reset() {
+	texture_params *params = NULL;
+	texture_params *tmp = NULL;
+	HASH_ITER(hh, params_by_name, params, tmp) {
+		HASH_DEL(params_by_name, params);
+		free(params);
+	}
+
+	gl_state_invalidate_bindings();
+}
+
+/**
+ * @name	gl_state_blend_func
+ * @brief	sets the blend function if it differs from the shadowed one
+ * @param	sfactor - (GLenum) source blend factor
+ * @param	dfactor - (GLenum) destination blend factor
+ * @retval	NONE
+ */
+void gl_state_blend_func(GLenum sfactor, GLenum dfactor) {
+	if (blend_sfactor == (GLint) sfactor && blend_dfactor == (GLint) dfactor) {
+		suppressed_calls++;
+		return;
+	}
+
+	blend_sfactor = sfactor;
+	blend_dfactor = dfactor;
+	GLTRACE(glBlendFunc(sfactor, dfactor));
+}
+
+/**
+ * @name	cap_state
+ * @brief	gets the shadow of a capability, if it is shadowed
+ * @param	cap - (GLenum) gl capability
+ * @retval	int* - pointer to the shadowed state or NULL
+ */
+static inline int *cap_state(GLenum cap) {
+	switch (cap) {
+		case GL_BLEND:
+			return &blend_enabled;
+		case GL_SCISSOR_TEST:
+			return &scissor_enabled;
+		default:
+			return NULL;
+	}
+}
+
+/**
+ * @name	gl_state_enable
+ * @brief	enables a gl capability unless it is known to be enabled
+ * @param	cap - (GLenum) gl capability
+ * @retval	NONE
+ */
+void gl_state_enable(GLenum cap) {
+	int *state = cap_state(cap);
+	if (state && *state == 1) {
+		suppressed_calls++;
+		return;
+	}
+
+	if (state) {
+		*state = 1;
+	}
+	GLTRACE(glEnable(cap));
+}
+
+/**
+ * @name	gl_state_disable
+ * @brief	disables a gl capability unless it is known to be disabled
+ * @param	cap - (GLenum) gl capability
+ * @retval	NONE
+ */
+void gl_state_disable(GLenum cap) {
+	int *state = cap_state(cap);
+	if (state && *state == 0) {
+		suppressed_calls++;
+		return;
+	}
+
+	if (state) {
+		*state = 0;
+	}
+	GLTRACE(glDisable(cap));
+}
+
+/**
+ * @name	gl_state_scissor
+ * @brief	sets the scissor box if it differs from the shadowed one
+ * @param	x - (GLint) left edge of the box
+ * @param	y - (GLint) bottom edge of the box
+ * @param	width - (GLsizei) width of the box
+ * @param	height - (GLsizei) height of the box
+ * @retval	NONE
+ */
+void gl_state_scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+	if (scissor_box[0] == x && scissor_box[1] == y && scissor_box[2] == width && scissor_box[3] == height) {
+		suppressed_calls++;
+		return;
+	}
+
+	scissor_box[0] = x;
+	scissor_box[1] = y;
+	scissor_box[2] = width;
+	scissor_box[3] = height;
+	GLTRACE(glScissor(x, y, width, height));
+}
+
+/**
+ * @name	gl_state_use_program
+ * @brief	makes a shader program current unless it already is
+ * @param	name - (GLuint) gl id of the program
+ * @retval	NONE
+ */
+void gl_state_use_program(GLuint name) {
+	if (program == (GLint) name) {
+		suppressed_calls++;
+		return;
+	}
+
+	program = name;
+	GLTRACE(glUseProgram(name));
+}
+
+/**
+ * @name	gl_state_active_texture
+ * @brief	selects the active texture unit unless it already is active
+ * @param	unit - (GLenum) GL_TEXTURE0 + the unit index
+ * @retval	NONE
+ */
+void gl_state_active_texture(GLenum unit) {
+	if (active_unit == (GLint) unit) {
+		suppressed_calls++;
+		return;
+	}
+
+	active_unit = unit;
+	GLTRACE(glActiveTexture(unit));
+}
+
+/**
+ * @name	gl_state_bind_texture
+ * @brief	binds a 2d texture to the active unit unless it is already bound there
+ * @param	name - (GLuint) gl id of the texture
+ * @retval	NONE
+ */
+void gl_state_bind_texture(GLuint name) {
+	int unit = active_unit == UNKNOWN ? UNKNOWN : active_unit - GL_TEXTURE0;
+	bool shadowed = unit >= 0 && unit < GL_STATE_TEXTURE_UNITS;
+	if (shadowed && bound_textures[unit] == (GLint) name) {
+		suppressed_calls++;
+		return;
+	}
+
+	if (shadowed) {
+		bound_textures[unit] = name;
+	}
+	GLTRACE(glBindTexture(GL_TEXTURE_2D, name));
+}
+
+/**
+ * @name	gl_state_texture_params
+ * @brief	sets the sampler parameters of a texture unless they are already set.
+ *			The texture must be bound to the active unit.
+ * @param	name - (GLuint) gl id of the bound texture
+ * @param	min_filter - (GLint) minification filter
+ * @param	mag_filter - (GLint) magnification filter
+ * @param	wrap_s - (GLint) horizontal wrap mode
+ * @param	wrap_t - (GLint) vertical wrap mode
+ * @retval	NONE
+ */
+void gl_state_texture_params(GLuint name, GLint min_filter, GLint mag_filter, GLint wrap_s, GLint wrap_t) {
+	texture_params *params = NULL;
+	HASH_FIND_INT(params_by_name, &name, params);
+
+	if (!params) {
+		params = (texture_params *) malloc(sizeof(texture_params));
+		params->name = name;
+		params->min_filter = params->mag_filter = params->wrap_s = params->wrap_t = UNKNOWN;
+		HASH_ADD_INT(params_by_name, name, params);
+	}
+
+	if (params->min_filter != min_filter) {
+		params->min_filter = min_filter;
+		GLTRACE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter));
+	} else {
+		suppressed_calls++;
+	}
+
+	if (params->mag_filter != mag_filter) {
+		params->mag_filter = mag_filter;
+		GLTRACE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter));
+	} else {
+		suppressed_calls++;
+	}
+
+	if (params->wrap_s != wrap_s) {
+		params->wrap_s = wrap_s;
+		GLTRACE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s));
+	} else {
+		suppressed_calls++;
+	}
+
+	if (params->wrap_t != wrap_t) {
+		params->wrap_t = wrap_t;
+		GLTRACE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t));
+	} else {
+		suppressed_calls++;
+	}
+}
+
+/**
+ * @name	gl_state_forget_texture
+ * @brief	drops the shadowed state of a texture that is being deleted
+ * @param	name - (GLuint) gl id of the texture
+ * @retval	NONE
+ */
+void gl_state_forget_texture(GLuint name) {
+	texture_params *params = NULL;
+	HASH_FIND_INT(params_by_name, &name, params);
+
+	if (params) {
+		HASH_DEL(params_by_name, params);
+		free(params);
+	}
+
+	// gl unbinds deleted textures from every unit
+	int i;
+	for (i = 0; i < GL_STATE_TEXTURE_UNITS; i++) {
+		if (bound_textures[i] == (GLint) name) {
+			bound_textures[i] = 0;
+		}
+	}
+}
+
+/**
+ * @name	gl_state_bind_buffer
+ * @brief	binds a buffer object unless it is already bound to the target
+ * @param	target - (GLenum) GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+ * @param	buffer - (GLuint) gl id of the buffer
+ * @retval	NONE
+ */
+void gl_state_bind_buffer(GLenum target, GLuint buffer) {
+	GLint *bound = target == GL_ARRAY_BUFFER ? &array_buffer :
+	               target == GL_ELEMENT_ARRAY_BUFFER ? &element_array_buffer : NULL;
+	if (bound && *bound == (GLint) buffer) {
+		suppressed_calls++;
+		return;
+	}
+
+	if (bound) {
+		*bound = buffer;
+	}
+	GLTRACE(glBindBuffer(target, buffer));
+}
+
+/**
+ * @name	gl_state_get_suppressed_calls
+ * @brief	gets the number of gl calls skipped because they matched the shadowed state
+ * @retval	unsigned int - number of suppressed calls
+ */
+unsigned int gl_state_get_suppressed_calls() {
+	return suppressed_calls;
+}
@@ -0,0 +1,47 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "core/types.h"
+#include "platform/gl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// texture units whose bindings are shadowed
+#define GL_STATE_TEXTURE_UNITS 16
+
+void gl_state_reset();
+void gl_state_invalidate_bindings();
+void gl_state_blend_func(GLenum sfactor, GLenum dfactor);
+void gl_state_enable(GLenum cap);
+void gl_state_disable(GLenum cap);
+void gl_state_scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+void gl_state_use_program(GLuint program);
+void gl_state_active_texture(GLenum unit);
+void gl_state_bind_texture(GLuint name);
+void gl_state_texture_params(GLuint name, GLint min_filter, GLint mag_filter, GLint wrap_s, GLint wrap_t);
+void gl_state_forget_texture(GLuint name);
+void gl_state_bind_buffer(GLenum target, GLuint buffer);
+unsigned int gl_state_get_suppressed_calls();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GL_STATE_H
@@ -18,7 +18,10 @@
 
 #define GL_GLEXT_PROTOTYPES
 
-#ifdef ANDROID
+// Define GL_RECORDING to swap gl for a recording stub that needs no GPU
+#ifdef GL_RECORDING
+#include "platform/gl_recording.h"
+#elif defined(ANDROID)
 #define GL_ES
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
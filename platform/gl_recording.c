@@ -0,0 +1,547 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+/**
+ * @file	 gl_recording.c
+ * @brief	recording gl implementation for GL_RECORDING builds. Objects are
+ *			tracked by name with their sizes, shader locations are handed out
+ *			per program, and nothing is ever rendered.
+ */
+#ifdef GL_RECORDING
+
+#include "platform/gl.h"
+#include "core/deps/uthash/uthash.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_UNITS 32
+#define MAX_LOCATIONS 32
+
+enum object_kind {
+	OBJECT_TEXTURE,
+	OBJECT_BUFFER,
+	OBJECT_FRAMEBUFFER,
+	OBJECT_SHADER,
+	OBJECT_PROGRAM
+};
+
+typedef struct gl_object_t {
+	GLuint name;
+	int kind;
+	int width;
+	int height;
+	size_t bytes;
+	// texture attached to a framebuffer
+	GLuint attachment;
+	// uniform and attribute names of a program, the index is the location
+	char *locations[MAX_LOCATIONS];
+	int location_count;
+	UT_hash_handle hh;
+} gl_object;
+
+static gl_object *objects = NULL;
+static GLuint next_name = 1;
+static gl_recording_stats stats;
+static GLenum active_unit = GL_TEXTURE0;
+static GLuint bound_textures[MAX_UNITS];
+static GLuint bound_buffers[2];
+static GLuint bound_framebuffer = 0;
+static GLuint current_program = 0;
+
+#define CALL() stats.calls++
+
+/**
+ * @name	new_object
+ * @brief	creates a tracked object with a fresh name
+ * @param	kind - (int) object_kind of the new object
+ * @retval	gl_object* - the new object
+ */
+static gl_object *new_object(int kind) {
+	gl_object *object = (gl_object *) calloc(1, sizeof(gl_object));
+	object->name = next_name++;
+	object->kind = kind;
+	HASH_ADD_INT(objects, name, object);
+
+	switch (kind) {
+		case OBJECT_TEXTURE:
+			stats.textures++;
+			break;
+
+		case OBJECT_FRAMEBUFFER:
+			stats.framebuffers++;
+			break;
+
+		case OBJECT_PROGRAM:
+			stats.programs++;
+			break;
+	}
+
+	return object;
+}
+
+/**
+ * @name	find_object
+ * @brief	finds a tracked object by name
+ * @param	name - (GLuint) gl name of the object
+ * @retval	gl_object* - the object or NULL if the name is unknown
+ */
+static gl_object *find_object(GLuint name) {
+	gl_object *object = NULL;
+	HASH_FIND_INT(objects, &name, object);
+	return object;
+}
+
+/**
+ * @name	delete_object
+ * @brief	stops tracking an object
+ * @param	object - (gl_object *) object to delete
+ * @retval	NONE
+ */
+static void delete_object(gl_object *object) {
+	int i;
+	for (i = 0; i < object->location_count; i++) {
+		free(object->locations[i]);
+	}
+
+	switch (object->kind) {
+		case OBJECT_TEXTURE:
+			stats.textures--;
+			break;
+
+		case OBJECT_FRAMEBUFFER:
+			stats.framebuffers--;
+			break;
+
+		case OBJECT_PROGRAM:
+			stats.programs--;
+			break;
+	}
+
+	HASH_DEL(objects, object);
+	free(object);
+}
+
+/**
+ * @name	location_of
+ * @brief	gets the location of a named uniform or attribute, giving each new
+ *			name of a program the next free location
+ * @param	program - (GLuint) gl name of the program
+ * @param	name - (const GLchar *) name of the uniform or attribute
+ * @retval	GLint - the location or -1 if the program is unknown or full
+ */
+static GLint location_of(GLuint program, const GLchar *name) {
+	gl_object *object = find_object(program);
+	if (!object) {
+		return -1;
+	}
+
+	int i;
+	for (i = 0; i < object->location_count; i++) {
+		if (!strcmp(object->locations[i], name)) {
+			return i;
+		}
+	}
+
+	if (object->location_count == MAX_LOCATIONS) {
+		return -1;
+	}
+
+	object->locations[object->location_count] = strdup(name);
+	return object->location_count++;
+}
+
+/**
+ * @name	bytes_per_pixel
+ * @brief	gets the size of a pixel of the given format
+ * @param	format - (GLenum) pixel format
+ * @retval	int - bytes per pixel
+ */
+static int bytes_per_pixel(GLenum format) {
+	switch (format) {
+		case GL_LUMINANCE:
+			return 1;
+
+		case GL_RGB:
+			return 3;
+
+		default:
+			return 4;
+	}
+}
+
+/**
+ * @name	gl_recording_reset
+ * @brief	forgets every object and binding, as if a new context was created
+ * @retval	NONE
+ */
+void gl_recording_reset() {
+	gl_object *object = NULL;
+	gl_object *tmp = NULL;
+	HASH_ITER(hh, objects, object, tmp) {
+		delete_object(object);
+	}
+
+	active_unit = GL_TEXTURE0;
+	memset(bound_textures, 0, sizeof(bound_textures));
+	memset(bound_buffers, 0, sizeof(bound_buffers));
+	bound_framebuffer = 0;
+	current_program = 0;
+	gl_recording_reset_stats();
+}
+
+/**
+ * @name	gl_recording_get_stats
+ * @brief	gets the calls and bytes recorded since the last reset
+ * @retval	gl_recording_stats* - the recorded stats
+ */
+gl_recording_stats *gl_recording_get_stats() {
+	return &stats;
+}
+
+/**
+ * @name	gl_recording_reset_stats
+ * @brief	zeroes the call and byte counters, keeping the live object counts
+ * @retval	NONE
+ */
+void gl_recording_reset_stats() {
+	unsigned int textures = stats.textures;
+	unsigned int framebuffers = stats.framebuffers;
+	unsigned int programs = stats.programs;
+	memset(&stats, 0, sizeof(stats));
+	stats.textures = textures;
+	stats.framebuffers = framebuffers;
+	stats.programs = programs;
+}
+
+void glActiveTexture(GLenum texture) {
+	CALL();
+	stats.state_changes++;
+	active_unit = texture;
+}
+
+void glAttachShader(GLuint program, GLuint shader) {
+	(void) program; (void) shader;
+	CALL();
+}
+
+void glBindBuffer(GLenum target, GLuint buffer) {
+	CALL();
+	stats.state_changes++;
+	bound_buffers[target == GL_ELEMENT_ARRAY_BUFFER] = buffer;
+}
+
+void glBindFramebuffer(GLenum target, GLuint framebuffer) {
+	(void) target;
+	CALL();
+	stats.framebuffer_binds++;
+	bound_framebuffer = framebuffer;
+}
+
+void glBindTexture(GLenum target, GLuint texture) {
+	(void) target;
+	CALL();
+	stats.texture_binds++;
+	unsigned int unit = active_unit - GL_TEXTURE0;
+	if (unit < MAX_UNITS) {
+		bound_textures[unit] = texture;
+	}
+}
+
+void glBlendFunc(GLenum sfactor, GLenum dfactor) {
+	(void) sfactor; (void) dfactor;
+	CALL();
+	stats.state_changes++;
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage) {
+	(void) usage;
+	CALL();
+	gl_object *object = find_object(bound_buffers[target == GL_ELEMENT_ARRAY_BUFFER]);
+	if (object) {
+		object->bytes = size;
+	}
+	if (data) {
+		stats.buffer_bytes += size;
+	}
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data) {
+	(void) target; (void) offset; (void) data;
+	CALL();
+	stats.buffer_bytes += size;
+}
+
+GLenum glCheckFramebufferStatus(GLenum target) {
+	(void) target;
+	CALL();
+	return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void glClear(GLbitfield mask) {
+	(void) mask;
+	CALL();
+	stats.draw_calls++;
+}
+
+void glCompileShader(GLuint shader) {
+	(void) shader;
+	CALL();
+}
+
+GLuint glCreateProgram() {
+	CALL();
+	return new_object(OBJECT_PROGRAM)->name;
+}
+
+GLuint glCreateShader(GLenum type) {
+	(void) type;
+	CALL();
+	return new_object(OBJECT_SHADER)->name;
+}
+
+void glDeleteTextures(GLsizei n, const GLuint *textures) {
+	CALL();
+	int i, unit;
+	for (i = 0; i < n; i++) {
+		gl_object *object = find_object(textures[i]);
+		if (object && object->kind == OBJECT_TEXTURE) {
+			delete_object(object);
+		}
+		for (unit = 0; unit < MAX_UNITS; unit++) {
+			if (bound_textures[unit] == textures[i]) {
+				bound_textures[unit] = 0;
+			}
+		}
+	}
+}
+
+void glDisable(GLenum cap) {
+	(void) cap;
+	CALL();
+	stats.state_changes++;
+}
+
+void glDisableVertexAttribArray(GLuint index) {
+	(void) index;
+	CALL();
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+	(void) mode; (void) first;
+	CALL();
+	stats.draw_calls++;
+	stats.vertices += count;
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices) {
+	(void) mode; (void) type; (void) indices;
+	CALL();
+	stats.draw_calls++;
+	stats.vertices += count;
+}
+
+void glEnable(GLenum cap) {
+	(void) cap;
+	CALL();
+	stats.state_changes++;
+}
+
+void glEnableVertexAttribArray(GLuint index) {
+	(void) index;
+	CALL();
+}
+
+void glFinish() {
+	CALL();
+}
+
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+	(void) target; (void) attachment; (void) textarget; (void) level;
+	CALL();
+	gl_object *object = find_object(bound_framebuffer);
+	if (object) {
+		object->attachment = texture;
+	}
+}
+
+void glGenBuffers(GLsizei n, GLuint *buffers) {
+	CALL();
+	int i;
+	for (i = 0; i < n; i++) {
+		buffers[i] = new_object(OBJECT_BUFFER)->name;
+	}
+}
+
+void glGenFramebuffers(GLsizei n, GLuint *framebuffers) {
+	CALL();
+	int i;
+	for (i = 0; i < n; i++) {
+		framebuffers[i] = new_object(OBJECT_FRAMEBUFFER)->name;
+	}
+}
+
+void glGenTextures(GLsizei n, GLuint *textures) {
+	CALL();
+	int i;
+	for (i = 0; i < n; i++) {
+		textures[i] = new_object(OBJECT_TEXTURE)->name;
+	}
+}
+
+GLint glGetAttribLocation(GLuint program, const GLchar *name) {
+	CALL();
+	return location_of(program, name);
+}
+
+GLenum glGetError() {
+	CALL();
+	return GL_NO_ERROR;
+}
+
+void glGetIntegerv(GLenum pname, GLint *params) {
+	CALL();
+	switch (pname) {
+		case GL_MAX_TEXTURE_IMAGE_UNITS:
+			*params = 8;
+			break;
+
+		default:
+			*params = 0;
+			break;
+	}
+}
+
+void glGetProgramInfoLog(GLuint program, GLsizei bufsize, GLsizei *length, GLchar *infolog) {
+	(void) program;
+	CALL();
+	if (length) {
+		*length = 0;
+	}
+	if (infolog && bufsize > 0) {
+		infolog[0] = '\0';
+	}
+}
+
+void glGetProgramiv(GLuint program, GLenum pname, GLint *params) {
+	(void) program;
+	CALL();
+	*params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+void glGetShaderiv(GLuint shader, GLenum pname, GLint *params) {
+	(void) shader;
+	CALL();
+	*params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+GLint glGetUniformLocation(GLuint program, const GLchar *name) {
+	CALL();
+	return location_of(program, name);
+}
+
+void glLinkProgram(GLuint program) {
+	(void) program;
+	CALL();
+}
+
+void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels) {
+	(void) x; (void) y; (void) type;
+	CALL();
+	size_t bytes = (size_t) width * height * bytes_per_pixel(format);
+	memset(pixels, 0, bytes);
+	stats.read_bytes += bytes;
+}
+
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+	(void) x; (void) y; (void) width; (void) height;
+	CALL();
+	stats.state_changes++;
+}
+
+void glShaderSource(GLuint shader, GLsizei count, const GLchar **string, const GLint *length) {
+	(void) shader; (void) count; (void) string; (void) length;
+	CALL();
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
+	(void) target; (void) level; (void) internalformat; (void) border; (void) type;
+	CALL();
+	size_t bytes = (size_t) width * height * bytes_per_pixel(format);
+	unsigned int unit = active_unit - GL_TEXTURE0;
+	gl_object *object = unit < MAX_UNITS ? find_object(bound_textures[unit]) : NULL;
+	if (object) {
+		object->width = width;
+		object->height = height;
+		object->bytes = bytes;
+	}
+	if (pixels) {
+		stats.texture_bytes += bytes;
+	}
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param) {
+	(void) target; (void) pname; (void) param;
+	CALL();
+	stats.state_changes++;
+}
+
+void glUniform1f(GLint location, GLfloat x) {
+	(void) location; (void) x;
+	CALL();
+}
+
+void glUniform1i(GLint location, GLint x) {
+	(void) location; (void) x;
+	CALL();
+}
+
+void glUniform1iv(GLint location, GLsizei count, const GLint *v) {
+	(void) location; (void) count; (void) v;
+	CALL();
+}
+
+void glUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+	(void) location; (void) x; (void) y; (void) z; (void) w;
+	CALL();
+}
+
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+	(void) location; (void) count; (void) transpose; (void) value;
+	CALL();
+}
+
+void glUseProgram(GLuint program) {
+	CALL();
+	stats.state_changes++;
+	current_program = program;
+}
+
+void glVertexAttrib4f(GLuint indx, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+	(void) indx; (void) x; (void) y; (void) z; (void) w;
+	CALL();
+}
+
+void glVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid *ptr) {
+	(void) indx; (void) size; (void) type; (void) normalized; (void) stride; (void) ptr;
+	CALL();
+}
+
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+	(void) x; (void) y; (void) width; (void) height;
+	CALL();
+	stats.state_changes++;
+}
+
+#endif // GL_RECORDING
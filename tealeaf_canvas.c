@@ -23,6 +23,7 @@
 #include "core/texture_manager.h"
 #include "core/tealeaf_context.h"
 #include "core/draw_textures.h"
+#include "core/gl_state.h"
 #include "core/config.h"
 #include "core/log.h"
 #include "geometry.h"
@@ -53,6 +54,16 @@ void tealeaf_canvas_init(int framebuffer_name) {
 	GLTRACE(glGenFramebuffers(1, &offscreen_buffer_name));
 	canvas.offscreen_framebuffer = offscreen_buffer_name;
 	canvas.view_framebuffer = framebuffer_name;
+
+	// a single opaque white texel lets solid fills batch with textured quads
+	static const unsigned char white_texel[4] = {255, 255, 255, 255};
+	GLuint fill_rect_tex;
+	GLTRACE(glGenTextures(1, &fill_rect_tex));
+	gl_state_bind_texture(fill_rect_tex);
+	gl_state_texture_params(fill_rect_tex, GL_LINEAR, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	GLTRACE(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white_texel));
+	canvas.fill_rect_tex = fill_rect_tex;
+
 	canvas.onscreen_ctx = context_2d_init(&canvas, "onscreen", -1, true);
 	canvas.onscreen_ctx->width = width;
 	canvas.onscreen_ctx->height = height;
@@ -71,7 +82,7 @@ void tealeaf_canvas_bind_texture_buffer(context_2d *ctx) {
 		return;
 	}
 
-	GLTRACE(glBindTexture(GL_TEXTURE_2D, tex->name));
+	gl_state_bind_texture(tex->name);
 	GLTRACE(glFinish());
 	GLTRACE(glBindFramebuffer(GL_FRAMEBUFFER, canvas.offscreen_framebuffer));
 	GLTRACE(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex->name, 0));
@@ -141,8 +152,8 @@ void tealeaf_canvas_resize(int w, int h) {
 		context_2d_clear(ctx);
 	}
 
-	GLTRACE(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
-	GLTRACE(glEnable(GL_BLEND));
+	gl_state_blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	gl_state_enable(GL_BLEND);
 	config_set_screen_width(w);
 	config_set_screen_height(h);
 	canvas.should_resize = true;
@@ -19,8 +19,10 @@
  */
 #include "core/tealeaf_context.h"
 #include "core/tealeaf_shaders.h"
+#include "core/gl_state.h"
 #include "core/log.h"
 #include "core/draw_textures.h"
+#include "core/draw_recorder.h"
 #include "core/texture_2d.h"
 #include "core/texture_manager.h"
 #include "core/geometry.h"
@@ -35,9 +37,6 @@
 #define GET_CLIPPING_BOUNDS(ctx) (&ctx->clipStack[ctx->mvp])
 #define IS_SCISSOR_ENABLED(ctx) (GET_CLIPPING_BOUNDS(ctx)->width >= 0)
 
-static rect_2d last_scissor_rect;
-
-
 /**
  * @name	tealeaf_context_set_proj_matrix
  * @brief	set the context's ortho projection using properties on the context
@@ -87,6 +86,8 @@ void tealeaf_context_update_viewport(context_2d *ctx, bool force) {
 	tealeaf_context_update_shader(ctx, PRIMARY_SHADER, force);
 	tealeaf_context_update_shader(ctx, FILL_RECT_SHADER, force);
 	tealeaf_context_update_shader(ctx, LINEAR_ADD_SHADER, force);
+	tealeaf_context_update_shader(ctx, PRIMARY_MULTI_SHADER, force);
+	tealeaf_context_update_shader(ctx, LINEAR_ADD_MULTI_SHADER, force);
 	GLTRACE(glViewport(0, 0, ctx->backing_width, ctx->backing_height));
 }
 
@@ -101,11 +102,10 @@ void tealeaf_context_update_viewport(context_2d *ctx, bool force) {
  * @retval	NONE
  */
 void print_model_view(context_2d *ctx, int i) {
-	matrix_3x3 m __attribute__((unused)) = ctx->modelView[i];
-	LOG("%f %f %f \n %f %f %f\n %f %f %f\n",
+	matrix_2x3 m __attribute__((unused)) = ctx->modelView[i];
+	LOG("%f %f %f \n %f %f %f\n",
 	    m.m00, m.m01, m.m02,
-	    m.m10, m.m11, m.m12,
-	    m.m20, m.m21, m.m22);
+	    m.m10, m.m11, m.m12);
 }
 
 /**
@@ -115,32 +115,19 @@ void print_model_view(context_2d *ctx, int i) {
  * @retval	NONE
  */
 void disable_scissor(context_2d *ctx) {
-	draw_textures_flush();
-	last_scissor_rect.x = last_scissor_rect.y = 0;
-	last_scissor_rect.width = last_scissor_rect.height = -1;
-	GLTRACE(glDisable(GL_SCISSOR_TEST));
+	rect_2d none = {0, 0, -1, -1};
+	draw_textures_apply_scissor(&none);
 }
 
 /**
  * @name	enable_scissor
- * @brief   enables the use of glScissors using proprties from the given context
+ * @brief   applies the given context's clipping rect to glScissors. Texture draws
+ *			apply their clip lazily, other draws must call this first.
  * @param	ctx - (context_2d *)
  * @retval	NONE
  */
 void enable_scissor(context_2d *ctx) {
-	rect_2d *bounds = GET_CLIPPING_BOUNDS(ctx);
-
-	if (rect_2d_equals(&last_scissor_rect, bounds)) {
-		return;
-	}
-
-	draw_textures_flush();
-	last_scissor_rect.x = bounds->x;
-	last_scissor_rect.y = bounds->y;
-	last_scissor_rect.width = bounds->width;
-	last_scissor_rect.height = bounds->height;
-	GLTRACE(glScissor((int) bounds->x, (int) bounds->y, (int) bounds->width, (int) bounds->height));
-	GLTRACE(glEnable(GL_SCISSOR_TEST));
+	draw_textures_apply_scissor(GET_CLIPPING_BOUNDS(ctx));
 }
 
 /**
@@ -163,6 +150,7 @@ context_2d *context_2d_init(tealeaf_canvas *canvas, const char *url, int dest_te
 	ctx->filter_color.b = 0.0;
 	ctx->filter_color.a = 0.0;
 	ctx->filter_type = FILTER_NONE;
+	ctx->preserve_contents = false;
 
 	if (!on_screen) {
 		texture_2d *tex = texture_manager_get_texture(texture_manager_get(), url);
@@ -188,7 +176,7 @@ context_2d *context_2d_init(tealeaf_canvas *canvas, const char *url, int dest_te
 	ctx->clipStack[0].y = 0;
 	ctx->clipStack[0].width = -1;
 	ctx->clipStack[0].height = -1;
-	matrix_3x3_identity(&ctx->modelView[0]);
+	matrix_2x3_identity(&ctx->modelView[0]);
 	context_2d_clear(ctx);
 	return ctx;
 }
@@ -231,6 +219,14 @@ context_2d *context_2d_new(tealeaf_canvas *canvas, const char *url, int dest_tex
  * @retval	NONE
  */
 void context_2d_delete(context_2d *ctx) {
+	// draw what is batched for the context while its texture exists, and make
+	// sure the next bind goes through even if a new context reuses its address
+	tealeaf_canvas *canvas = tealeaf_canvas_get();
+	if (canvas->active_ctx == ctx) {
+		draw_textures_flush();
+		canvas->active_ctx = NULL;
+	}
+
 	texture_2d *tex = texture_manager_get_texture(texture_manager_get(), (char *)ctx->url);
 
 	if (tex) {
@@ -263,17 +259,15 @@ float context_2d_getGlobalAlpha(context_2d *ctx) {
 
 /**
  * @name	context_2d_bind
- * @brief	bind's the given context to gl and enables / disables scissors
+ * @brief	bind's the given context to gl
  * @param	ctx - (context_2d *) context to bind
  * @retval	NONE
  */
 void context_2d_bind(context_2d *ctx) {
-	if (tealeaf_canvas_context_2d_bind(ctx)) {
-		if (IS_SCISSOR_ENABLED(ctx)) {
-			enable_scissor(ctx);
-		} else {
-			disable_scissor(ctx);
-		}
+	// the clip is applied to gl by each draw, see enable_scissor
+	tealeaf_canvas_context_2d_bind(ctx);
+	if (draw_recorder_recording) {
+		draw_recorder_bind(ctx);
 	}
 }
 
@@ -326,12 +320,12 @@ void context_2d_set_filter_type(context_2d *ctx, int filter_type) {
  * @retval	NONE
  */
 void context_2d_setClip(context_2d *ctx, rect_2d clip) {
-	matrix_3x3 *modelView = GET_MODEL_VIEW_MATRIX(ctx);
+	const matrix_2x3 *modelView = GET_MODEL_VIEW_MATRIX(ctx);
 	//  LOG("setClip: %f %f %f %f", clip.x, clip.y, clip.width, clip.height);
 	// TODO: clipping with rectangles doesn't work so great with rotated or scaled coordinates...
 	float x1, y1, x2, y2;
-	matrix_3x3_multiply(modelView, clip.x, clip.y, &x1, &y1);
-	matrix_3x3_multiply(modelView, clip.x + clip.width, clip.y + clip.height, &x2, &y2);
+	matrix_2x3_multiply(modelView, clip.x, clip.y, &x1, &y1);
+	matrix_2x3_multiply(modelView, clip.x + clip.width, clip.y + clip.height, &x2, &y2);
 	clip.x = x1;
 	clip.y = y1;
 	clip.width = x2 - x1;
@@ -378,7 +372,6 @@ void context_2d_setClip(context_2d *ctx, rect_2d clip) {
 	}
 
 	*GET_CLIPPING_BOUNDS(ctx) = bounds;
-	enable_scissor(ctx);
 }
 
 /**
@@ -388,7 +381,7 @@ void context_2d_setClip(context_2d *ctx, rect_2d clip) {
  * @retval	NONE
  */
 void context_2d_save(context_2d *ctx) {
-	if (ctx->mvp + 1 > MODEL_VIEW_STACK_SIZE) {
+	if (ctx->mvp + 1 >= MODEL_VIEW_STACK_SIZE) {
 		LOG("{context} WARNING: Stack size exceeded");
 		return;
 	}
@@ -401,20 +394,12 @@ void context_2d_save(context_2d *ctx) {
 
 /**
  * @name	context_2d_restore
- * @brief	pop's off the global properties stacks and resets glScissors
+ * @brief	pop's off the global properties stacks
  * @param	ctx - (context_2d *) context to restore
  * @retval	NONE
  */
 void context_2d_restore(context_2d *ctx) {
 	ctx->mvp--;
-
-	if (!rect_2d_equals(&ctx->clipStack[ctx->mvp], &ctx->clipStack[ctx->mvp + 1])) {
-		if (ctx->clipStack[ctx->mvp].width == -1) {
-			disable_scissor(ctx);
-		} else {
-			enable_scissor(ctx);
-		}
-	}
 }
 
 //TODO: this should only do a glClear with proper clear color settings
@@ -425,8 +410,16 @@ void context_2d_restore(context_2d *ctx) {
  * @retval	NONE
  */
 void context_2d_clear(context_2d *ctx) {
+	if (ctx->preserve_contents) {
+		return;
+	}
+
+	if (draw_recorder_recording) {
+		draw_recorder_clear(ctx);
+	}
 	draw_textures_flush();
 	context_2d_bind(ctx);
+	enable_scissor(ctx);
 	GLTRACE(glClear(GL_COLOR_BUFFER_BIT));
 }
 
@@ -437,7 +430,7 @@ void context_2d_clear(context_2d *ctx) {
  * @retval	NONE
  */
 void context_2d_loadIdentity(context_2d *ctx) {
-	matrix_3x3_identity(GET_MODEL_VIEW_MATRIX(ctx));
+	matrix_2x3_identity(GET_MODEL_VIEW_MATRIX(ctx));
 }
 
 /**
@@ -449,7 +442,7 @@ void context_2d_loadIdentity(context_2d *ctx) {
  */
 void context_2d_rotate(context_2d *ctx, float angle) {
 	if (angle != 0) {
-		matrix_3x3_rotate(GET_MODEL_VIEW_MATRIX(ctx), angle);
+		matrix_2x3_rotate(GET_MODEL_VIEW_MATRIX(ctx), angle);
 	}
 }
 
@@ -463,7 +456,7 @@ void context_2d_rotate(context_2d *ctx, float angle) {
  */
 void context_2d_translate(context_2d *ctx, float x, float y) {
 	if (x != 0 || y != 0) {
-		matrix_3x3_translate(GET_MODEL_VIEW_MATRIX(ctx), x, y);
+		matrix_2x3_translate(GET_MODEL_VIEW_MATRIX(ctx), x, y);
 	}
 }
 
@@ -482,8 +475,8 @@ void context_2d_translate(context_2d *ctx, float x, float y) {
  * @retval	NONE
  */
 void context_2d_draw_point_sprites(context_2d *ctx, const char *url, float point_size, float step_size, rgba *color, float x1, float y1, float x2, float y2) {
-	draw_textures_flush();
 	context_2d_bind(ctx);
+	enable_scissor(ctx);
 	texture_2d *tex = texture_manager_load_texture(texture_manager_get(), url);
 
 	// If texture is not finished loading,
@@ -491,52 +484,10 @@ void context_2d_draw_point_sprites(context_2d *ctx, const char *url, float point
 		return;
 	}
 
-	static GLfloat     *vertex_buffer = NULL;
-	static unsigned int vertex_max = 64;
-	tealeaf_shaders_bind(DRAWING_SHADER);
-	matrix_3x3_multiply_m_f_f_f_f(GET_MODEL_VIEW_MATRIX(ctx), x1, y1, &x1, &y1);
-	matrix_3x3_multiply_m_f_f_f_f(GET_MODEL_VIEW_MATRIX(ctx), x2, y2, &x2, &y2);
-
-	// Allocate vertex array buffer
-	if (vertex_buffer == NULL) {
-		vertex_buffer = malloc(vertex_max * 2 * sizeof(GLfloat));
-	}
-
-	// Add points to the buffer so there are drawing points every X pixels
-	unsigned int count = ceilf(sqrtf((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1)) / step_size);
-
-	if (count < 1) {
-		count = 1;
-	}
-
-	unsigned int vertex_count = 0;
-	unsigned int i;
-
-	for (i = 0; i < count; ++i) {
-		if (vertex_count == vertex_max) {
-			vertex_max = 2 * vertex_max;
-			vertex_buffer = realloc(vertex_buffer, vertex_max * 2 * sizeof(GLfloat));
-		}
-
-		vertex_buffer[2 * vertex_count + 0] = x1 + (x2 - x1) * ((GLfloat)i / (GLfloat)count);
-		vertex_buffer[2 * vertex_count + 1] = y1 + (y2 - y1) * ((GLfloat)i / (GLfloat)count);
-		vertex_count += 1;
-	}
-
-	GLTRACE(glActiveTexture(GL_TEXTURE0));
-	GLTRACE(glBindTexture(GL_TEXTURE_2D, tex->name));
-	GLTRACE(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
-	GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-	GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-	GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-	GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-	// Render the vertex array
-	GLTRACE(glUniform1f(global_shaders[DRAWING_SHADER].point_size, point_size));
-	GLTRACE(glVertexAttribPointer(global_shaders[DRAWING_SHADER].vertex_coords, 2, GL_FLOAT, GL_FALSE, 0, (float *) vertex_buffer));
-	float alpha = color->a * ctx->globalAlpha[ctx->mvp];
-	GLTRACE(glUniform4f(global_shaders[DRAWING_SHADER].draw_color, alpha * color->r, alpha * color->g, alpha * color->b, alpha));
-	GLTRACE(glDrawArrays(GL_POINTS, 0, vertex_count));
-	tealeaf_shaders_bind(PRIMARY_SHADER);
+	// segments are batched until the brush or anything else drawn changes
+	rgba brush = *color;
+	brush.a *= ctx->globalAlpha[ctx->mvp];
+	draw_textures_point_sprites(GET_MODEL_VIEW_MATRIX(ctx), tex->name, point_size, step_size, &brush, x1, y1, x2, y2);
 }
 
 /**
@@ -548,7 +499,41 @@ void context_2d_draw_point_sprites(context_2d *ctx, const char *url, float point
  * @retval	NONE
  */
 void context_2d_scale(context_2d *ctx, float x, float y) {
-	matrix_3x3_scale(GET_MODEL_VIEW_MATRIX(ctx), x, y);
+	matrix_2x3_scale(GET_MODEL_VIEW_MATRIX(ctx), x, y);
+}
+
+/**
+ * @name	context_2d_transform
+ * @brief	applies a transform to the given context, as if its translations,
+ *			rotations and scales were applied one after the other
+ * @param	ctx - (context_2d *) context to transform
+ * @param	m - (const matrix_2x3 *) transform to apply
+ * @retval	NONE
+ */
+void context_2d_transform(context_2d *ctx, const matrix_2x3 *m) {
+	matrix_2x3 *model_view = GET_MODEL_VIEW_MATRIX(ctx);
+	matrix_2x3_multiply(model_view, m, model_view);
+}
+
+/**
+ * @name	context_2d_setTransform
+ * @brief	replaces the model view of the given context
+ * @param	ctx - (context_2d *) context to set the model view of
+ * @param	m - (const matrix_2x3 *) new model view
+ * @retval	NONE
+ */
+void context_2d_setTransform(context_2d *ctx, const matrix_2x3 *m) {
+	*GET_MODEL_VIEW_MATRIX(ctx) = *m;
+}
+
+/**
+ * @name	context_2d_get_model_view
+ * @brief	gets the current model view of the given context
+ * @param	ctx - (context_2d *) context to get the model view of
+ * @retval	const matrix_2x3* - the model view, valid until the context is next modified
+ */
+const matrix_2x3 *context_2d_get_model_view(context_2d *ctx) {
+	return GET_MODEL_VIEW_MATRIX(ctx);
 }
 
 /**
@@ -559,8 +544,22 @@ void context_2d_scale(context_2d *ctx, float x, float y) {
  * @retval	NONE
  */
 void context_2d_clearRect(context_2d *ctx, const rect_2d *rect) {
+	if (draw_recorder_recording) {
+		draw_recorder_clear_rect(ctx, rect);
+	}
+
+	// destination-out with opaque source clears the covered pixels, so the
+	// clear can join the sprite batch
+	if (ctx->canvas->fill_rect_tex) {
+		static const rgba clear_color = {0, 0, 0, 1};
+		context_2d_bind(ctx);
+		draw_textures_fill_rect(GET_MODEL_VIEW_MATRIX(ctx), ctx->canvas->fill_rect_tex, *rect, *GET_CLIPPING_BOUNDS(ctx), &clear_color, destination_out);
+		return;
+	}
+
 	draw_textures_flush();
 	context_2d_bind(ctx);
+	enable_scissor(ctx);
 	// Draw a rectangle using triangle strip:
 	//    (0,1)-(2,3)-(4,5) and (2,3)-(4,5)-(6,7)
 	//
@@ -569,12 +568,17 @@ void context_2d_clearRect(context_2d *ctx, const rect_2d *rect) {
 	//     |   \   |
 	//    0,1  -  2,3
 	GLfloat v[8];
-	matrix_3x3_multiply(GET_MODEL_VIEW_MATRIX(ctx), rect, (float *)&v[4], (float *)&v[5], (float *)&v[6], (float *)&v[7], (float *)&v[2], (float *)&v[3], (float *)&v[0], (float *)&v[1]);
-	GLTRACE(glBlendFunc(GL_ONE, GL_ZERO));
-	GLTRACE(glUniform4f(global_shaders[PRIMARY_SHADER].draw_color, 0, 0, 0, 0)); // set color to 0
-	GLTRACE(glVertexAttribPointer(global_shaders[PRIMARY_SHADER].vertex_coords, 2, GL_FLOAT, GL_FALSE, 0, v));
+	matrix_2x3_multiply(GET_MODEL_VIEW_MATRIX(ctx), rect, (float *)&v[4], (float *)&v[5], (float *)&v[6], (float *)&v[7], (float *)&v[2], (float *)&v[3], (float *)&v[0], (float *)&v[1]);
+	tealeaf_shaders_bind(PRIMARY_SHADER);
+	tealeaf_shader *shader = &global_shaders[PRIMARY_SHADER];
+	gl_state_blend_func(GL_ONE, GL_ZERO);
+	// color is per-vertex in the primary shader, use a constant 0 for the clear
+	GLTRACE(glDisableVertexAttribArray(shader->vertex_color));
+	GLTRACE(glVertexAttrib4f(shader->vertex_color, 0, 0, 0, 0)); // set color to 0
+	GLTRACE(glVertexAttribPointer(shader->vertex_coords, 2, GL_FLOAT, GL_FALSE, 0, v));
 	GLTRACE(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
-	GLTRACE(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+	GLTRACE(glEnableVertexAttribArray(shader->vertex_color));
+	gl_state_blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 /**
@@ -601,11 +605,11 @@ void tealeaf_context_update_shader(context_2d *ctx, unsigned int shader_type, bo
 		m.m10 = proj->m10;m.m11 = proj->m11;m.m12 = 0;m.m13 = proj->m12;
 		m.m20 = 0;        m.m21 = 0;        m.m22 = 1;m.m23 = 0;
 		m.m30 = proj->m20;m.m31 = proj->m21;m.m32 = 0;m.m33 = proj->m22;
-		GLTRACE(glUseProgram(shader->program));
+		gl_state_use_program(shader->program);
 		GLTRACE(glUniformMatrix4fv(shader->proj_matrix, 1, false, (float *) &m));
 		shader->last_width = width;
 		shader->last_height = height;
-		GLTRACE(glUseProgram(global_shaders[current_shader].program));
+		gl_state_use_program(global_shaders[current_shader].program);
 	}
 }
 
@@ -620,17 +624,32 @@ void tealeaf_context_update_shader(context_2d *ctx, unsigned int shader_type, bo
  * @retval	NONE
  */
 void context_2d_fillRect(context_2d *ctx, const rect_2d *rect, const rgba *color, int composite_op) {
+	if (draw_recorder_recording) {
+		draw_recorder_fill_rect(ctx, rect, color, composite_op);
+	}
+
 	if (use_single_shader) {
 		return;
 	}
 
+	// fills are drawn from the white texel through the sprite batch, the fill
+	// rect shader is only needed when the texel could not be created
+	if (ctx->canvas->fill_rect_tex) {
+		rgba fill = *color;
+		fill.a *= ctx->globalAlpha[ctx->mvp];
+		context_2d_bind(ctx);
+		draw_textures_fill_rect(GET_MODEL_VIEW_MATRIX(ctx), ctx->canvas->fill_rect_tex, *rect, *GET_CLIPPING_BOUNDS(ctx), &fill, source_over);
+		return;
+	}
+
 	draw_textures_flush();
 	context_2d_bind(ctx);
+	enable_scissor(ctx);
 	tealeaf_shaders_bind(FILL_RECT_SHADER);
-	GLTRACE(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+	gl_state_blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 	rect_2d_vertices in, out;
 	rect_2d_to_rect_2d_vertices(rect, &in);
-	matrix_3x3_multiply_m_r_r(GET_MODEL_VIEW_MATRIX(ctx), &in, &out);
+	matrix_2x3_multiply_m_r_r(GET_MODEL_VIEW_MATRIX(ctx), &in, &out);
 	float alpha = color->a * ctx->globalAlpha[ctx->mvp];
 	// TODO: will pre-multiplied alpha cause a loss-of-precision in color for filling rectangles?
 	GLTRACE(glUniform4f(global_shaders[FILL_RECT_SHADER].draw_color, alpha * color->r, alpha * color->g, alpha * color->b, alpha));
@@ -654,7 +673,12 @@ void context_2d_fillText(context_2d *ctx, texture_2d *img, const rect_2d *srcRec
 	context_2d_bind(ctx);
 
 	if (img && img->loaded) {
+		if (draw_recorder_recording) {
+			draw_recorder_image(ctx, img, srcRect, destRect, ctx->globalAlpha[ctx->mvp] * alpha, composite_op);
+		}
 		draw_textures_item(GET_MODEL_VIEW_MATRIX(ctx), img->name, img->width, img->height, img->originalWidth, img->originalHeight, *srcRect, *destRect, *GET_CLIPPING_BOUNDS(ctx), ctx->globalAlpha[ctx->mvp] * alpha, composite_op, &ctx->filter_color, ctx->filter_type);
+	} else if (draw_recorder_recording) {
+		draw_recorder_skip();
 	}
 }
 
@@ -684,7 +708,12 @@ void context_2d_drawImage(context_2d *ctx, int srcTex, const char *url, const re
 	texture_2d *tex = texture_manager_load_texture(texture_manager_get(), url);
 
 	if (tex && tex->loaded) {
+		if (draw_recorder_recording) {
+			draw_recorder_image(ctx, tex, srcRect, destRect, ctx->globalAlpha[ctx->mvp], composite_op);
+		}
 		draw_textures_item(GET_MODEL_VIEW_MATRIX(ctx), tex->name, tex->width, tex->height, tex->originalWidth, tex->originalHeight, *srcRect, *destRect, * GET_CLIPPING_BOUNDS(ctx), ctx->globalAlpha[ctx->mvp], composite_op, &ctx->filter_color, ctx->filter_type);
+	} else if (draw_recorder_recording) {
+		draw_recorder_skip();
 	}
 }
 
@@ -44,11 +44,13 @@ typedef struct context_2d_t {
 	bool on_screen;
 	matrix_3x3 proj_matrix;
 	float globalAlpha[MODEL_VIEW_STACK_SIZE];
-	matrix_3x3 modelView[MODEL_VIEW_STACK_SIZE];
+	matrix_2x3 modelView[MODEL_VIEW_STACK_SIZE];
 	unsigned int mvp; // model view pointer
 	rect_2d clipStack[MODEL_VIEW_STACK_SIZE];
 	rgba filter_color;
 	int filter_type;
+	// clear() is skipped, the renderer clears the regions it redraws
+	bool preserve_contents;
 } context_2d;
 
 enum filter_mode {
@@ -92,6 +94,9 @@ void context_2d_loadIdentity(context_2d *ctx);
 void context_2d_rotate(context_2d *ctx, float angle);
 void context_2d_translate(context_2d *ctx, float x, float y);
 void context_2d_scale(context_2d *ctx, float x, float y);
+void context_2d_transform(context_2d *ctx, const matrix_2x3 *m);
+void context_2d_setTransform(context_2d *ctx, const matrix_2x3 *m);
+const matrix_2x3 *context_2d_get_model_view(context_2d *ctx);
 void context_2d_clearRect(context_2d *ctx, const rect_2d *rect);
 void context_2d_fillRect(context_2d *ctx, const rect_2d *rect, const rgba *color, int composite_op);
 void context_2d_fillText(context_2d *ctx, texture_2d *img, const rect_2d *srcRect, const rect_2d *destRect, float alpha, int composite_op);
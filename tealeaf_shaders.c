@@ -21,20 +21,28 @@
 #include "tealeaf_context.h"
 #include "platform/gl.h"
 #include "core/log.h"
+#include "core/gl_state.h"
 #include <stdlib.h>
+#include <stdio.h>
 
 static char *linear_add_vertex_shader_code = "														\
 																						\
   attribute vec2 attr_vertex_coord;														\
   attribute vec2 attr_tex_coord;														\
+  attribute vec4 attr_color;															\
+  attribute vec4 attr_add_color;														\
   																						\
   uniform mat4 proj_matrix;																\
 																						\
   varying vec2 v_tex_coord;																\
+  varying lowp vec4 v_color;															\
+  varying lowp vec4 v_add_color;														\
 																						\
   void main(void) {																		\
     gl_Position = proj_matrix * vec4(attr_vertex_coord, 0.0, 1.0);						\
     v_tex_coord = attr_tex_coord;														\
+    v_color = attr_color;																\
+    v_add_color = attr_add_color;														\
   }																						\
 ";
 
@@ -49,29 +57,32 @@ static char *linear_add_fragment_shader_code = "													\
 	precision mediump float;															\
 																						\
 	varying vec2 v_tex_coord;															\
-	uniform lowp vec4 draw_color;														\
-	uniform lowp vec4 add_color;														\
+	varying lowp vec4 v_color;															\
+	varying lowp vec4 v_add_color;														\
 																						\
 	uniform sampler2D tex_sampler;														\
 																						\
 	void main(void) {	\
-		vec4 base = draw_color*texture2D(tex_sampler, v_tex_coord.st) ;	\
+		vec4 base = v_color*texture2D(tex_sampler, v_tex_coord.st) ;	\
 		float a = base.a;\
-		gl_FragColor = base + add_color * a;\
+		gl_FragColor = base + v_add_color * a;\
 	}";
 
 static char *vertex_shader_code = "														\
 																						\
   attribute vec2 attr_vertex_coord;														\
   attribute vec2 attr_tex_coord;														\
+  attribute vec4 attr_color;															\
   																						\
   uniform mat4 proj_matrix;																\
 																						\
   varying vec2 v_tex_coord;																\
+  varying lowp vec4 v_color;															\
 																						\
   void main(void) {																		\
     gl_Position = proj_matrix * vec4(attr_vertex_coord, 0.0, 1.0);						\
     v_tex_coord = attr_tex_coord;														\
+    v_color = attr_color;																\
   }																						\
 ";
 
@@ -79,15 +90,94 @@ static char *fragment_shader_code = "													\
 	precision mediump float;															\
 																						\
 	varying vec2 v_tex_coord;															\
-	uniform lowp vec4 draw_color;														\
-	uniform lowp vec4 add_color;														\
+	varying lowp vec4 v_color;															\
 																						\
 	uniform sampler2D tex_sampler;														\
 																						\
 	void main(void) {	\
-		gl_FragColor= draw_color*texture2D(tex_sampler, v_tex_coord.st) ;                 \
+		gl_FragColor= v_color*texture2D(tex_sampler, v_tex_coord.st) ;                 \
+	}";
+
+/*
+ * Multi-texture batch shaders. Each vertex carries the index of the
+ * texture unit its quad samples from, so quads from up to
+ * MAX_BATCH_TEXTURES different textures can share one draw call.
+ * GLSL ES 1.0 only allows constant sampler array indices in fragment
+ * shaders, so the fragment shaders are generated at init time with a
+ * branch per texture unit (see build_multi_fragment_shader).
+ */
+static char *primary_multi_vertex_shader_code = "										\
+																						\
+  attribute vec2 attr_vertex_coord;														\
+  attribute vec2 attr_tex_coord;														\
+  attribute vec4 attr_color;															\
+  attribute float attr_tex_index;														\
+  																						\
+  uniform mat4 proj_matrix;																\
+																						\
+  varying vec2 v_tex_coord;																\
+  varying lowp vec4 v_color;															\
+  varying float v_tex_index;															\
+																						\
+  void main(void) {																		\
+    gl_Position = proj_matrix * vec4(attr_vertex_coord, 0.0, 1.0);						\
+    v_tex_coord = attr_tex_coord;														\
+    v_color = attr_color;																\
+    v_tex_index = attr_tex_index;														\
+  }																						\
+";
+
+static char *linear_add_multi_vertex_shader_code = "									\
+																						\
+  attribute vec2 attr_vertex_coord;														\
+  attribute vec2 attr_tex_coord;														\
+  attribute vec4 attr_color;															\
+  attribute vec4 attr_add_color;														\
+  attribute float attr_tex_index;														\
+  																						\
+  uniform mat4 proj_matrix;																\
+																						\
+  varying vec2 v_tex_coord;																\
+  varying lowp vec4 v_color;															\
+  varying lowp vec4 v_add_color;														\
+  varying float v_tex_index;															\
+																						\
+  void main(void) {																		\
+    gl_Position = proj_matrix * vec4(attr_vertex_coord, 0.0, 1.0);						\
+    v_tex_coord = attr_tex_coord;														\
+    v_color = attr_color;																\
+    v_add_color = attr_add_color;														\
+    v_tex_index = attr_tex_index;														\
+  }																						\
+";
+
+static char *primary_multi_fragment_main = "											\
+	void main(void) {																	\
+		gl_FragColor = v_color * sample_batch_texture();								\
 	}";
 
+static char *linear_add_multi_fragment_main = "											\
+	void main(void) {																	\
+		vec4 base = v_color * sample_batch_texture();									\
+		float a = base.a;																\
+		gl_FragColor = base + v_add_color * a;											\
+	}";
+
+static char primary_multi_fragment_shader_code[2048];
+static char linear_add_multi_fragment_shader_code[2048];
+static int batch_texture_units = 1;
+
+static char *fill_rect_vertex_shader_code = "											\
+																						\
+  attribute vec2 attr_vertex_coord;														\
+  																						\
+  uniform mat4 proj_matrix;																\
+																						\
+  void main(void) {																		\
+    gl_Position = proj_matrix * vec4(attr_vertex_coord, 0.0, 1.0);						\
+  }																						\
+";
+
 static char *fill_rect_fragment_shader_code = "											\
 	precision mediump float;															\
 																						\
@@ -203,7 +293,7 @@ int tealeaf_shaders_load(char *vertex_shader_code, char *fragment_shader_code, c
 void tealeaf_shaders_primary_init() {
 	tealeaf_shader *shader = &global_shaders[PRIMARY_SHADER];
 	shader->program = tealeaf_shaders_load(vertex_shader_code, fragment_shader_code, "primary");
-	GLTRACE(glUseProgram(shader->program));
+	gl_state_use_program(shader->program);
 	// texture binding -- always use texture 0
 	shader->tex_sampler = glGetUniformLocation(shader->program, "tex_sampler");
 	GLTRACE(glUniform1i(shader->tex_sampler, 0));
@@ -212,7 +302,10 @@ void tealeaf_shaders_primary_init() {
 	// shader binding for vertex/texture coordinates
 	shader->tex_coords = glGetAttribLocation(shader->program, "attr_tex_coord");
 	shader->vertex_coords = glGetAttribLocation(shader->program, "attr_vertex_coord");
-	shader->draw_color = glGetUniformLocation(shader->program, "draw_color");
+	// per-vertex premultiplied draw color
+	shader->vertex_color = glGetAttribLocation(shader->program, "attr_color");
+	shader->vertex_add_color = -1;
+	shader->tex_index = -1;
 }
 
 /**
@@ -223,7 +316,7 @@ void tealeaf_shaders_primary_init() {
 void tealeaf_shaders_linear_add_init() {
 	tealeaf_shader *shader = &global_shaders[LINEAR_ADD_SHADER];
 	shader->program = tealeaf_shaders_load(linear_add_vertex_shader_code, linear_add_fragment_shader_code, "linear add");
-	GLTRACE(glUseProgram(shader->program));
+	gl_state_use_program(shader->program);
 	// texture binding -- always use texture 0
 	shader->tex_sampler = glGetUniformLocation(shader->program, "tex_sampler");
 	GLTRACE(glUniform1i(shader->tex_sampler, 0));
@@ -232,8 +325,74 @@ void tealeaf_shaders_linear_add_init() {
 	// shader binding for vertex/texture coordinates
 	shader->tex_coords = glGetAttribLocation(shader->program, "attr_tex_coord");
 	shader->vertex_coords = glGetAttribLocation(shader->program, "attr_vertex_coord");
-	shader->draw_color = glGetUniformLocation(shader->program, "draw_color");
-	shader->add_color = glGetUniformLocation(shader->program, "add_color");
+	// per-vertex premultiplied draw color and linear add color
+	shader->vertex_color = glGetAttribLocation(shader->program, "attr_color");
+	shader->vertex_add_color = glGetAttribLocation(shader->program, "attr_add_color");
+	shader->tex_index = -1;
+}
+
+/**
+ * @name	build_multi_fragment_shader
+ * @brief	generates a multi-texture batch fragment shader sampling from the
+ *			texture unit selected by the per-vertex texture index
+ * @param	out - (char *) buffer to write the shader code to
+ * @param	size - (size_t) size of the output buffer
+ * @param	units - (int) number of texture units to sample from
+ * @param	linear_add - (bool) whether to generate the linear add variant
+ * @retval	NONE
+ */
+static void build_multi_fragment_shader(char *out, size_t size, int units, bool linear_add) {
+	int len = snprintf(out, size,
+		"precision mediump float;\n"
+		"varying vec2 v_tex_coord;\n"
+		"varying lowp vec4 v_color;\n"
+		"%s"
+		"varying float v_tex_index;\n"
+		"uniform sampler2D tex_samplers[%d];\n"
+		"vec4 sample_batch_texture() {\n",
+		linear_add ? "varying lowp vec4 v_add_color;\n" : "", units);
+
+	int i;
+	for (i = 0; i < units - 1; i++) {
+		len += snprintf(out + len, size - len,
+			"\tif (v_tex_index < %d.5) return texture2D(tex_samplers[%d], v_tex_coord.st);\n", i, i);
+	}
+
+	len += snprintf(out + len, size - len,
+		"\treturn texture2D(tex_samplers[%d], v_tex_coord.st);\n}\n%s",
+		units - 1, linear_add ? linear_add_multi_fragment_main : primary_multi_fragment_main);
+}
+
+/**
+ * @name	tealeaf_shaders_multi_init
+ * @brief	initializes a multi-texture batch shader's code and variables
+ * @param	shader_type - (unsigned int) either PRIMARY_MULTI_SHADER or LINEAR_ADD_MULTI_SHADER
+ * @retval	NONE
+ */
+void tealeaf_shaders_multi_init(unsigned int shader_type) {
+	tealeaf_shader *shader = &global_shaders[shader_type];
+	bool linear_add = shader_type == LINEAR_ADD_MULTI_SHADER;
+	char *fragment_code = linear_add ? linear_add_multi_fragment_shader_code : primary_multi_fragment_shader_code;
+	build_multi_fragment_shader(fragment_code, sizeof(primary_multi_fragment_shader_code), batch_texture_units, linear_add);
+	shader->program = tealeaf_shaders_load(linear_add ? linear_add_multi_vertex_shader_code : primary_multi_vertex_shader_code,
+	                                       fragment_code, linear_add ? "linear add multi" : "primary multi");
+	gl_state_use_program(shader->program);
+	// texture binding -- sampler i reads texture unit i
+	GLint units[MAX_BATCH_TEXTURES];
+	int i;
+	for (i = 0; i < batch_texture_units; i++) {
+		units[i] = i;
+	}
+	shader->tex_sampler = glGetUniformLocation(shader->program, "tex_samplers");
+	GLTRACE(glUniform1iv(shader->tex_sampler, batch_texture_units, units));
+	// shader binding for projection matrix
+	shader->proj_matrix = glGetUniformLocation(shader->program, "proj_matrix");
+	// shader binding for vertex/texture coordinates
+	shader->tex_coords = glGetAttribLocation(shader->program, "attr_tex_coord");
+	shader->vertex_coords = glGetAttribLocation(shader->program, "attr_vertex_coord");
+	shader->vertex_color = glGetAttribLocation(shader->program, "attr_color");
+	shader->vertex_add_color = linear_add ? glGetAttribLocation(shader->program, "attr_add_color") : -1;
+	shader->tex_index = glGetAttribLocation(shader->program, "attr_tex_index");
 }
 
 /**
@@ -244,7 +403,7 @@ void tealeaf_shaders_linear_add_init() {
 void tealeaf_shaders_drawing_init() {
 	tealeaf_shader *shader = &global_shaders[DRAWING_SHADER];
 	shader->program = tealeaf_shaders_load(drawing_vertex_shader_code, drawing_fragment_shader_code, "drawing");
-	GLTRACE(glUseProgram(shader->program));
+	gl_state_use_program(shader->program);
 	shader->tex_sampler = glGetUniformLocation(shader->program, "tex_sampler");
 	GLTRACE(glUniform1i(shader->tex_sampler, 0));
 	// shader binding for projection matrix
@@ -262,8 +421,8 @@ void tealeaf_shaders_drawing_init() {
  */
 void tealeaf_shaders_fill_rect_init() {
 	tealeaf_shader *shader = &global_shaders[FILL_RECT_SHADER];
-	shader->program = tealeaf_shaders_load(vertex_shader_code, fill_rect_fragment_shader_code, "fill rect");
-	GLTRACE(glUseProgram(shader->program));
+	shader->program = tealeaf_shaders_load(fill_rect_vertex_shader_code, fill_rect_fragment_shader_code, "fill rect");
+	gl_state_use_program(shader->program);
 	// shader binding for projection matrix
 	shader->proj_matrix = glGetUniformLocation(shader->program, "proj_matrix");
 	// shader binding for vertex/texture coordinates
@@ -278,9 +437,10 @@ void tealeaf_shaders_fill_rect_init() {
  */
 static void inline tealeaf_shaders_primary_bind() {
 	tealeaf_shader *shader = &global_shaders[PRIMARY_SHADER];
-	GLTRACE(glUseProgram(shader->program));
+	gl_state_use_program(shader->program);
 	GLTRACE(glEnableVertexAttribArray(shader->vertex_coords));
 	GLTRACE(glEnableVertexAttribArray(shader->tex_coords));
+	GLTRACE(glEnableVertexAttribArray(shader->vertex_color));
 }
 
 /**
@@ -292,6 +452,7 @@ static void inline tealeaf_shaders_primary_unbind() {
 	tealeaf_shader *shader = &global_shaders[PRIMARY_SHADER];
 	GLTRACE(glDisableVertexAttribArray(shader->vertex_coords));
 	GLTRACE(glDisableVertexAttribArray(shader->tex_coords));
+	GLTRACE(glDisableVertexAttribArray(shader->vertex_color));
 }
 
 /**
@@ -301,7 +462,7 @@ static void inline tealeaf_shaders_primary_unbind() {
  */
 static void inline tealeaf_shaders_fill_rect_bind() {
 	tealeaf_shader *shader = &global_shaders[FILL_RECT_SHADER];
-	GLTRACE(glUseProgram(shader->program));
+	gl_state_use_program(shader->program);
 	GLTRACE(glEnableVertexAttribArray(shader->vertex_coords));
 }
 
@@ -322,7 +483,7 @@ static void inline tealeaf_shaders_fill_rect_unbind() {
  */
 static void inline tealeaf_shaders_drawing_bind() {
 	tealeaf_shader *shader = &global_shaders[DRAWING_SHADER];
-	GLTRACE(glUseProgram(shader->program));
+	gl_state_use_program(shader->program);
 	GLTRACE(glEnableVertexAttribArray(shader->vertex_coords));
 }
 
@@ -343,9 +504,11 @@ static void inline tealeaf_shaders_drawing_unbind() {
  */
 static void inline tealeaf_shaders_linear_add_bind() {
 	tealeaf_shader *shader = &global_shaders[LINEAR_ADD_SHADER];
-	GLTRACE(glUseProgram(shader->program));
+	gl_state_use_program(shader->program);
 	GLTRACE(glEnableVertexAttribArray(shader->tex_coords));
 	GLTRACE(glEnableVertexAttribArray(shader->vertex_coords));
+	GLTRACE(glEnableVertexAttribArray(shader->vertex_color));
+	GLTRACE(glEnableVertexAttribArray(shader->vertex_add_color));
 }
 
 /**
@@ -357,6 +520,43 @@ static void inline tealeaf_shaders_linear_add_unbind() {
 	tealeaf_shader *shader = &global_shaders[LINEAR_ADD_SHADER];
 	GLTRACE(glDisableVertexAttribArray(shader->vertex_coords));
 	GLTRACE(glDisableVertexAttribArray(shader->tex_coords));
+	GLTRACE(glDisableVertexAttribArray(shader->vertex_color));
+	GLTRACE(glDisableVertexAttribArray(shader->vertex_add_color));
+}
+
+/**
+ * @name	tealeaf_shaders_multi_bind
+ * @brief	binds a multi-texture batch shader's program / attributes
+ * @param	shader_type - (unsigned int) either PRIMARY_MULTI_SHADER or LINEAR_ADD_MULTI_SHADER
+ * @retval	NONE
+ */
+static void inline tealeaf_shaders_multi_bind(unsigned int shader_type) {
+	tealeaf_shader *shader = &global_shaders[shader_type];
+	gl_state_use_program(shader->program);
+	GLTRACE(glEnableVertexAttribArray(shader->vertex_coords));
+	GLTRACE(glEnableVertexAttribArray(shader->tex_coords));
+	GLTRACE(glEnableVertexAttribArray(shader->vertex_color));
+	GLTRACE(glEnableVertexAttribArray(shader->tex_index));
+	if (shader->vertex_add_color != -1) {
+		GLTRACE(glEnableVertexAttribArray(shader->vertex_add_color));
+	}
+}
+
+/**
+ * @name	tealeaf_shaders_multi_unbind
+ * @brief	unbinds a multi-texture batch shader's program / attributes
+ * @param	shader_type - (unsigned int) either PRIMARY_MULTI_SHADER or LINEAR_ADD_MULTI_SHADER
+ * @retval	NONE
+ */
+static void inline tealeaf_shaders_multi_unbind(unsigned int shader_type) {
+	tealeaf_shader *shader = &global_shaders[shader_type];
+	GLTRACE(glDisableVertexAttribArray(shader->vertex_coords));
+	GLTRACE(glDisableVertexAttribArray(shader->tex_coords));
+	GLTRACE(glDisableVertexAttribArray(shader->vertex_color));
+	GLTRACE(glDisableVertexAttribArray(shader->tex_index));
+	if (shader->vertex_add_color != -1) {
+		GLTRACE(glDisableVertexAttribArray(shader->vertex_add_color));
+	}
 }
 
 /**
@@ -379,6 +579,8 @@ void tealeaf_shaders_bind(unsigned int shader_type) {
 		tealeaf_shaders_fill_rect_unbind();
 	} else if (current_shader == LINEAR_ADD_SHADER) {
 		tealeaf_shaders_linear_add_unbind();
+	} else if (current_shader == PRIMARY_MULTI_SHADER || current_shader == LINEAR_ADD_MULTI_SHADER) {
+		tealeaf_shaders_multi_unbind(current_shader);
 	}
 
 	// bind new shader
@@ -390,6 +592,8 @@ void tealeaf_shaders_bind(unsigned int shader_type) {
 		tealeaf_shaders_fill_rect_bind();
 	} else if (shader_type == LINEAR_ADD_SHADER) {
 		tealeaf_shaders_linear_add_bind();
+	} else if (shader_type == PRIMARY_MULTI_SHADER || shader_type == LINEAR_ADD_MULTI_SHADER) {
+		tealeaf_shaders_multi_bind(shader_type);
 	}
 
 	tealeaf_context_update_shader(tealeaf_canvas_get()->active_ctx, shader_type, false);
@@ -403,9 +607,29 @@ void tealeaf_shaders_bind(unsigned int shader_type) {
  */
 void tealeaf_shaders_init() {
 	use_single_shader = false;
+
+	GLint max_units = 1;
+	GLTRACE(glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_units));
+	batch_texture_units = max_units < MAX_BATCH_TEXTURES ? max_units : MAX_BATCH_TEXTURES;
+	if (batch_texture_units < 1) {
+		batch_texture_units = 1;
+	}
+	LOG("{shaders} Using %d texture units for batching", batch_texture_units);
+
 	tealeaf_shaders_primary_init();
 	tealeaf_shaders_drawing_init();
 	tealeaf_shaders_fill_rect_init();
 	tealeaf_shaders_linear_add_init();
+	tealeaf_shaders_multi_init(PRIMARY_MULTI_SHADER);
+	tealeaf_shaders_multi_init(LINEAR_ADD_MULTI_SHADER);
 	tealeaf_shaders_primary_bind();
 }
+
+/**
+ * @name	tealeaf_shaders_get_batch_texture_units
+ * @brief	gets the number of texture units the multi-texture batch shaders sample from
+ * @retval	int - number of texture units, at most MAX_BATCH_TEXTURES
+ */
+int tealeaf_shaders_get_batch_texture_units() {
+	return batch_texture_units;
+}
@@ -17,7 +17,10 @@
 #define TEALEAF_SHADER_H
 #include "core/types.h"
 
-enum SHADERS { PRIMARY_SHADER, DRAWING_SHADER, FILL_RECT_SHADER, LINEAR_ADD_SHADER, NUM_SHADERS };
+// upper bound on texture units sampled by the multi-texture batch shaders
+#define MAX_BATCH_TEXTURES 8
+
+enum SHADERS { PRIMARY_SHADER, DRAWING_SHADER, FILL_RECT_SHADER, LINEAR_ADD_SHADER, PRIMARY_MULTI_SHADER, LINEAR_ADD_MULTI_SHADER, NUM_SHADERS };
 bool use_single_shader;
 typedef struct shader_t {
 	int program;
@@ -26,6 +29,9 @@ typedef struct shader_t {
 		// primary shader
 		struct {
 			int tex_coords;
+			int vertex_color;
+			int vertex_add_color;
+			int tex_index;
 		};
 
 		// drawing shader
@@ -53,5 +59,6 @@ unsigned int current_shader;
 
 void tealeaf_shaders_init();
 void tealeaf_shaders_bind(unsigned int shader_type);
+int tealeaf_shaders_get_batch_texture_units();
 
 #endif // TEALEAF_SHADER_H
@@ -26,6 +26,7 @@
 #include "core/log.h"
 #include "core/image_loader.h"
 #include "core/core.h"
+#include "core/gl_state.h"
 
 // Enable this to print out the texture loader scaling and resizing operations
 //#define VERBOSE_LOAD_TEX
@@ -121,11 +122,9 @@ texture_2d *texture_2d_new_from_url(char *url) {
 static inline int get_tex_from_data(int w, int h, void *data) {
 	GLuint name;
 	GLTRACE(glGenTextures(1, &name));
-	GLTRACE(glBindTexture(GL_TEXTURE_2D, name));
-	GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-	GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-	GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-	GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	gl_state_bind_texture(name);
+	// sampler state used by draw_textures, set once here
+	gl_state_texture_params(name, GL_LINEAR, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 	GLTRACE(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data));
 	return name;
 }
@@ -234,6 +233,7 @@ void texture_2d_reload(texture_2d *tex) {
  * @retval	NONE
  */
 void texture_2d_destroy(texture_2d *tex) {
+	gl_state_forget_texture(tex->name);
 	GLTRACE(glDeleteTextures(1, (const GLuint *)&tex->name));
 	free(tex->url);
 	free(tex->pixel_data);
@@ -25,6 +25,7 @@
 #include "platform/resource_loader.h"
 #include "core/list.h"
 #include "platform/gl.h"
+#include "core/gl_state.h"
 #include "core/events.h"
 #include "platform/native.h"
 #include "core/deps/jansson/jansson.h"
@@ -130,6 +131,14 @@ texture_2d *texture_manager_get_texture(texture_manager *manager, const char *ur
 	return tex;
 }
 
+// looks a texture up without counting it as used this frame
+texture_2d *texture_manager_find_texture(texture_manager *manager, const char *url) {
+	LOGFN("texture_manager_find_texture");
+	texture_2d *tex = NULL;
+	HASH_FIND(url_hash, manager->url_to_tex, url, strlen(url), tex);
+	return tex;
+}
+
 void texture_manager_get_sheet_size(char *url, int *width, int *height) {
 	LOGFN("texture_manager_get_sheet_size");
 	if (!spritesheet_map_root) {
@@ -697,11 +706,9 @@ void texture_manager_tick(texture_manager *manager) {
 
 		GLuint texture = 0;
 		GLTRACE(glGenTextures(1, &texture));
-		GLTRACE(glBindTexture(GL_TEXTURE_2D, texture));
-		GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
-		GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-		GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-		GLTRACE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+		gl_state_bind_texture(texture);
+		// sampler state used by draw_textures, set once here
+		gl_state_texture_params(texture, GL_LINEAR, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 		//create the texture
 		int channels = cur_tex->num_channels;
 		int width = cur_tex->width / cur_tex->scale;
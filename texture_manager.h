@@ -39,6 +39,7 @@ extern "C" {
 void texture_manager_tick(texture_manager *manager);
 texture_2d *texture_manager_new_texture(texture_manager *manager, int width, int height);
 texture_2d *texture_manager_get_texture(texture_manager *manager, const char *url);
+texture_2d *texture_manager_find_texture(texture_manager *manager, const char *url);
 texture_2d *texture_manager_add_texture(texture_manager *manager, texture_2d *tex, bool is_canvas);
 texture_2d *texture_manager_add_texture_from_image(texture_manager *manager, const char *url, int name, int width, int height, int original_width, int original_height);
 texture_2d *texture_manager_load_texture(texture_manager *manager, const char *url);
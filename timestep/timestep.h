@@ -19,8 +19,10 @@
 #define TIMESTEP_H
 
 #include <float.h>
+#include <stdint.h>
 
 #include "core/util/detect.h"
+#include "core/deps/uthash/uthash.h"
 #include "js/js.h"
 #include "core/rgba.h"
 #include "core/tealeaf_context.h"
@@ -34,31 +36,120 @@ struct view_animation_t;
 #define UNDEFINED_DIMENSION DBL_MIN
 
 enum view_types { DEFAULT_RENDER, IMAGE_VIEW };
+enum layout_types { LAYOUT_NONE, LAYOUT_BOX, LAYOUT_LINEAR };
+enum layout_directions { LAYOUT_HORIZONTAL, LAYOUT_VERTICAL };
+
+/*
+ * How the native layout pass sizes and places a view, see timestep_layout.h.
+ * Views with LAYOUT_NONE are laid out from js. Edge distances are measured
+ * from the superview's padding and are UNDEFINED_DIMENSION when unset.
+ */
+typedef struct view_layout_t {
+	unsigned int /* enum layout_types */ type;
+	// how a linear view stacks its subviews
+	unsigned int /* enum layout_directions */ direction;
+	double spacing;
+	double padding_top;
+	double padding_right;
+	double padding_bottom;
+	double padding_left;
+	double top;
+	double right;
+	double bottom;
+	double left;
+	bool center_x;
+	bool center_y;
+	// size of the view when its subviews were last laid out
+	double last_width;
+	double last_height;
+} view_layout;
+
+/*
+ * The view state that affects what a view draws, compared between frames
+ * to find the views that need to be redrawn when use_dirty_regions is on.
+ * Zeroed before it is filled so that padding compares equal.
+ */
+typedef struct view_snapshot_t {
+	double x;
+	double y;
+	double width;
+	double height;
+	double r;
+	double anchor_x;
+	double anchor_y;
+	double offset_x;
+	double offset_y;
+	double scale;
+	double opacity;
+	bool clip;
+	bool flip_x;
+	bool flip_y;
+	int z_index;
+	struct rgba_t background_color;
+	struct rgba_t filter_color;
+	int filter_type;
+	void *view_data;
+	// image map contents, maps are edited in place when sprites animate
+	const char *image_url;
+	int32_t image_rect[4];
+	// gl name of the image's texture once it has loaded
+	int image_texture;
+} view_snapshot;
+
+/*
+ * The properties a view's transform is built from, compared between frames
+ * to find the views whose cached transforms are stale. Besides the js
+ * setters, the animation engine, the layout pass and style records write
+ * these properties through the VIEW_* macros, so a compare catches every
+ * writer without each having to mark the view. Zeroed before it is filled
+ * so that padding compares equal.
+ */
+typedef struct view_transform_key_t {
+	double x;
+	double y;
+	double r;
+	double anchor_x;
+	double anchor_y;
+	double offset_x;
+	double offset_y;
+	double scale;
+} view_transform_key;
 
 typedef struct timestep_view_t {
 	unsigned int uid;
+	// registers the view by uid, see timestep_view_get
+	UT_hash_handle hh;
 	struct timestep_view_t **subviews;
 	struct timestep_view_t *superview;
 	unsigned int subview_array_size;
+	// subviews are kept sorted by z index and the order they were added in.
+	// Removed subviews leave NULL tombstones, counted in subview_count, until
+	// timestep_view_compact_subviews squeezes them out.
 	unsigned int subview_count;
+	unsigned int subview_tombstones;
 	unsigned int subview_index;
 
 	int added_at;
 
 	JS_OBJECT_WRAPPER js_view;
 	bool has_jsrender;
+	// set through timestep_view_set_has_jstick
 	bool has_jstick;
+	// views in the subtree, the view included, that tick
+	unsigned int subtree_tick_count;
 
 	// This reference is held to pin the js_view if it has a parent, so that
 	// the parent's reference is represented to the garbage collector (GC).
 	PERSISTENT_JS_OBJECT_WRAPPER pin_view;
 
+#ifdef TIMESTEP_VIEW_SOA
+	// index of the view's transform and visibility state in view_store
+	unsigned int slot;
+#else
 	double x;
 	double y;
 	double width;
 	double height;
-	double width_percent;
-	double height_percent;
 	double r;
 	double anchor_x;
 	double anchor_y;
@@ -66,9 +157,16 @@ typedef struct timestep_view_t {
 	double offset_y;
 	double scale;
 	double opacity;
+	bool visible;
+#endif
+	double width_percent;
+	double height_percent;
+	// set through timestep_layout_request
 	bool needs_reflow;
+	// the view or a view below it needs reflow
+	bool subtree_needs_reflow;
+	view_layout layout;
 	bool clip;
-	bool visible;
 	bool flip_x;
 	bool flip_y;
 
@@ -90,9 +188,129 @@ typedef struct timestep_view_t {
 
 	rgba filter_color;
 	int filter_type;
+
+	// state and bounds as of the last frame, for dirty region tracking
+	view_snapshot snapshot;
+	bool has_snapshot;
+	rect_2d last_bounds;
+
+	// render-to-texture cache of the subtree, see timestep_view_set_cache_as_bitmap
+	bool cache_as_bitmap;
+	bool cache_valid;
+	struct context_2d_t *cache_ctx;
+	uint64_t cache_hash;
+	rect_2d cache_bounds;
+	float cache_scale;
+
+	// draws of the js render, replayed natively until the view is marked
+	// dirty, see timestep_view_set_display_list. The inverse model view and
+	// alpha the list was recorded under map it to where it is drawn.
+	bool use_display_list;
+	bool display_list_valid;
+	bool display_list_rejected;
+	struct draw_recording_t *display_list;
+	matrix_2x3 display_list_inverse;
+	float display_list_alpha;
+	double display_list_width;
+	double display_list_height;
+
+#ifndef TIMESTEP_VIEW_SOA
+	// bounds of what the subtree draws this frame, in the space of the context
+	// the tree is rendered to, see use_bounds_culling
+	rect_2d subtree_bounds;
+#endif
+	bool subtree_unbounded;
+	// bounds pass that last visited the view, views attached since are not culled
+	unsigned int bounds_pass;
+	// covered by opaque views painted later, see use_occlusion_culling
+	bool occluded;
+
+	// transform from the superview's space, rebuilt when the key changes
+	view_transform_key transform_key;
+	matrix_2x3 local_transform;
+	bool has_local_transform;
+	bool local_is_identity;
+#ifndef TIMESTEP_VIEW_SOA
+	// local transform under the superview's world transform and flip, in the
+	// space of the context the tree was last rendered to
+	matrix_2x3 world_transform;
+#endif
+	// changes whenever the world transform does, so subviews can tell when
+	// theirs are stale
+	unsigned int transform_version;
+	unsigned int parent_transform_version;
 } timestep_view;
 
 
+/*
+ * With TIMESTEP_VIEW_SOA defined, the transform and visibility state of views,
+ * and the world transform and subtree bounds derived from it each frame, live
+ * in arrays indexed by the view's slot rather than in the views. The state is
+ * accessed through the VIEW_ macros in both modes. The js properties stay
+ * doubles so that they read back in js as they were set.
+ */
+#ifdef TIMESTEP_VIEW_SOA
+
+typedef struct timestep_view_store_t {
+	double *x;
+	double *y;
+	double *width;
+	double *height;
+	double *r;
+	double *anchor_x;
+	double *anchor_y;
+	double *offset_x;
+	double *offset_y;
+	double *scale;
+	double *opacity;
+	bool *visible;
+	matrix_2x3 *world_transform;
+	rect_2d *subtree_bounds;
+	// slots handed out so far and their capacity
+	unsigned int slot_count;
+	unsigned int capacity;
+	// slots of deleted views, reused before new ones
+	unsigned int *free_slots;
+	unsigned int free_count;
+} timestep_view_store;
+
+extern timestep_view_store view_store;
+
+#define VIEW_X(v) (view_store.x[(v)->slot])
+#define VIEW_Y(v) (view_store.y[(v)->slot])
+#define VIEW_WIDTH(v) (view_store.width[(v)->slot])
+#define VIEW_HEIGHT(v) (view_store.height[(v)->slot])
+#define VIEW_R(v) (view_store.r[(v)->slot])
+#define VIEW_ANCHOR_X(v) (view_store.anchor_x[(v)->slot])
+#define VIEW_ANCHOR_Y(v) (view_store.anchor_y[(v)->slot])
+#define VIEW_OFFSET_X(v) (view_store.offset_x[(v)->slot])
+#define VIEW_OFFSET_Y(v) (view_store.offset_y[(v)->slot])
+#define VIEW_SCALE(v) (view_store.scale[(v)->slot])
+#define VIEW_OPACITY(v) (view_store.opacity[(v)->slot])
+#define VIEW_VISIBLE(v) (view_store.visible[(v)->slot])
+#define VIEW_WORLD_TRANSFORM(v) (view_store.world_transform[(v)->slot])
+#define VIEW_SUBTREE_BOUNDS(v) (view_store.subtree_bounds[(v)->slot])
+
+#else
+
+#define VIEW_X(v) ((v)->x)
+#define VIEW_Y(v) ((v)->y)
+#define VIEW_WIDTH(v) ((v)->width)
+#define VIEW_HEIGHT(v) ((v)->height)
+#define VIEW_R(v) ((v)->r)
+#define VIEW_ANCHOR_X(v) ((v)->anchor_x)
+#define VIEW_ANCHOR_Y(v) ((v)->anchor_y)
+#define VIEW_OFFSET_X(v) ((v)->offset_x)
+#define VIEW_OFFSET_Y(v) ((v)->offset_y)
+#define VIEW_SCALE(v) ((v)->scale)
+#define VIEW_OPACITY(v) ((v)->opacity)
+#define VIEW_VISIBLE(v) ((v)->visible)
+#define VIEW_WORLD_TRANSFORM(v) ((v)->world_transform)
+#define VIEW_SUBTREE_BOUNDS(v) ((v)->subtree_bounds)
+
+#endif
+
+
 //// Animation
 
 enum frame_type { WAIT_FRAME, STYLE_FRAME, FUNC_FRAME };
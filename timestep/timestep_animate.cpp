@@ -289,17 +289,17 @@ static void init_frame(anim_frame *frame, timestep_view *v) {
 	style_prop *curr = *head;
 	while (curr) {
 		// copy the initial value from the view
-		#define SET_INITIAL_PROP(name, prop) case name: curr->initial = v->prop; break;
+		#define SET_INITIAL_PROP(name, prop) case name: curr->initial = prop(v); break;
 		switch (curr->name) {
-			SET_INITIAL_PROP(X, x)
-			SET_INITIAL_PROP(Y, y)
-			SET_INITIAL_PROP(WIDTH, width)
-			SET_INITIAL_PROP(HEIGHT, height)
-			SET_INITIAL_PROP(R, r)
-			SET_INITIAL_PROP(ANCHOR_X, anchor_x)
-			SET_INITIAL_PROP(ANCHOR_Y, anchor_y)
-			SET_INITIAL_PROP(OPACITY, opacity)
-			SET_INITIAL_PROP(SCALE, scale)
+			SET_INITIAL_PROP(X, VIEW_X)
+			SET_INITIAL_PROP(Y, VIEW_Y)
+			SET_INITIAL_PROP(WIDTH, VIEW_WIDTH)
+			SET_INITIAL_PROP(HEIGHT, VIEW_HEIGHT)
+			SET_INITIAL_PROP(R, VIEW_R)
+			SET_INITIAL_PROP(ANCHOR_X, VIEW_ANCHOR_X)
+			SET_INITIAL_PROP(ANCHOR_Y, VIEW_ANCHOR_Y)
+			SET_INITIAL_PROP(OPACITY, VIEW_OPACITY)
+			SET_INITIAL_PROP(SCALE, VIEW_SCALE)
 		}
 
 		// if the prop is not a delta, we must compute the delta
@@ -322,18 +322,18 @@ static void apply_frame(anim_frame *frame, timestep_view *view, double tt) {
 	style_prop *curr = *head;
 	while (curr) {
 		// copy the initial value from the view
-		 //#define UPDATE_PROP(name, prop) case name: LOG("view prop is %i %f time %f delta %f initial %f", name, view->prop, tt, curr->delta, curr->initial); view->prop = curr->delta * tt + curr->initial; break;
-		#define UPDATE_PROP(name, prop) case name: view->prop = curr->delta * tt + curr->initial; break;
+		 //#define UPDATE_PROP(name, prop) case name: LOG("view prop is %i %f time %f delta %f initial %f", name, prop(view), tt, curr->delta, curr->initial); prop(view) = curr->delta * tt + curr->initial; break;
+		#define UPDATE_PROP(name, prop) case name: prop(view) = curr->delta * tt + curr->initial; break;
 		switch (curr->name) {
-			UPDATE_PROP(X, x)
-			UPDATE_PROP(Y, y)
-			UPDATE_PROP(WIDTH, width)
-			UPDATE_PROP(HEIGHT, height)
-			UPDATE_PROP(R, r)
-			UPDATE_PROP(ANCHOR_X, anchor_x)
-			UPDATE_PROP(ANCHOR_Y, anchor_y)
-			UPDATE_PROP(OPACITY, opacity)
-			UPDATE_PROP(SCALE, scale)
+			UPDATE_PROP(X, VIEW_X)
+			UPDATE_PROP(Y, VIEW_Y)
+			UPDATE_PROP(WIDTH, VIEW_WIDTH)
+			UPDATE_PROP(HEIGHT, VIEW_HEIGHT)
+			UPDATE_PROP(R, VIEW_R)
+			UPDATE_PROP(ANCHOR_X, VIEW_ANCHOR_X)
+			UPDATE_PROP(ANCHOR_Y, VIEW_ANCHOR_Y)
+			UPDATE_PROP(OPACITY, VIEW_OPACITY)
+			UPDATE_PROP(SCALE, VIEW_SCALE)
 		}
 
 		LIST_ITERATE(head, curr);
@@ -399,7 +399,7 @@ static void view_animation_tick(view_animation *anim, int dt) {
 			default:
 				break;
 		}
-        if (isnan(view->x) || isnan(view->y) || isnan(view->width) || isnan(view->height)) {
+        if (isnan(VIEW_X(view)) || isnan(VIEW_Y(view)) || isnan(VIEW_WIDTH(view)) || isnan(VIEW_HEIGHT(view))) {
             //LOG("animated to NaN?");
         }
 		// if the frame is finished, remove it. However, if the frame head is not equal to the
@@ -0,0 +1,229 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+ 
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+ 
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+#include "core/timestep/timestep_layout.h"
+#include "core/log.h"
+#include <math.h>
+
+#define IS_SET(d) ((d) != UNDEFINED_DIMENSION)
+
+void timestep_layout_init(timestep_view *v) {
+	view_layout *layout = &v->layout;
+	layout->type = LAYOUT_NONE;
+	layout->direction = LAYOUT_VERTICAL;
+	layout->spacing = 0;
+	layout->padding_top = layout->padding_right = layout->padding_bottom = layout->padding_left = 0;
+	layout->top = layout->right = layout->bottom = layout->left = UNDEFINED_DIMENSION;
+	layout->center_x = layout->center_y = false;
+	layout->last_width = layout->last_height = UNDEFINED_DIMENSION;
+	v->needs_reflow = true;
+	v->subtree_needs_reflow = true;
+}
+
+// marks the view for reflow, to be called when its size or layout properties change
+void timestep_layout_request(timestep_view *v) {
+	v->needs_reflow = true;
+	v->subtree_needs_reflow = true;
+	// the superviews of a view needing reflow are marked, up to the root
+	for (v = v->superview; v && !v->subtree_needs_reflow; v = v->superview) {
+		v->subtree_needs_reflow = true;
+	}
+}
+
+// marks a view whose size or layout properties changed, along with a linear
+// superview whose other subviews it moves
+void timestep_layout_request_relayout(timestep_view *v) {
+	timestep_layout_request(v);
+	// views laid out from js take no space in a linear view either
+	if (v->superview && v->superview->layout.type == LAYOUT_LINEAR) {
+		timestep_layout_request(v->superview);
+	}
+}
+
+/*
+ * Accessors for the layout properties, used by the user getters and setters
+ * of the js bindings. Edge distances are NaN in js when unset.
+ */
+#define LAYOUT_ACCESSORS(name, type) \
+	type timestep_layout_get_##name(timestep_view *v) { return v->layout.name; } \
+	void timestep_layout_set_##name(timestep_view *v, type value) { \
+		if (v->layout.name != value) { \
+			v->layout.name = value; \
+			timestep_layout_request_relayout(v); \
+		} \
+	}
+
+#define LAYOUT_EDGE_ACCESSORS(name) \
+	double timestep_layout_get_##name(timestep_view *v) { return IS_SET(v->layout.name) ? v->layout.name : NAN; } \
+	void timestep_layout_set_##name(timestep_view *v, double value) { \
+		value = isnan(value) ? UNDEFINED_DIMENSION : value; \
+		if (v->layout.name != value) { \
+			v->layout.name = value; \
+			timestep_layout_request_relayout(v); \
+		} \
+	}
+
+LAYOUT_ACCESSORS(spacing, double)
+LAYOUT_ACCESSORS(padding_top, double)
+LAYOUT_ACCESSORS(padding_right, double)
+LAYOUT_ACCESSORS(padding_bottom, double)
+LAYOUT_ACCESSORS(padding_left, double)
+LAYOUT_EDGE_ACCESSORS(top)
+LAYOUT_EDGE_ACCESSORS(right)
+LAYOUT_EDGE_ACCESSORS(bottom)
+LAYOUT_EDGE_ACCESSORS(left)
+LAYOUT_ACCESSORS(center_x, bool)
+LAYOUT_ACCESSORS(center_y, bool)
+
+unsigned int timestep_layout_get_type(timestep_view *v) {
+	return v->layout.type;
+}
+
+void timestep_layout_set_type(timestep_view *v, unsigned int type) {
+	if (type > LAYOUT_LINEAR) {
+		LOG("{layout} WARNING: Ignoring unknown layout type %u", type);
+		return;
+	}
+	if (v->layout.type != type) {
+		v->layout.type = type;
+		timestep_layout_request_relayout(v);
+	}
+}
+
+unsigned int timestep_layout_get_direction(timestep_view *v) {
+	return v->layout.direction;
+}
+
+void timestep_layout_set_direction(timestep_view *v, unsigned int direction) {
+	if (direction > LAYOUT_VERTICAL) {
+		LOG("{layout} WARNING: Ignoring unknown layout direction %u", direction);
+		return;
+	}
+	if (v->layout.direction != direction) {
+		v->layout.direction = direction;
+		timestep_layout_request_relayout(v);
+	}
+}
+
+/*
+ * Sizes and places a view along one axis of its superview's content box.
+ * Sizes that are neither a percentage nor stretched between two edges are
+ * left as they are, and so are positions when no edge is set and the view
+ * is not centered.
+ */
+static void layout_axis(double content, double percent, double before, double after, bool center, double *size, double *pos) {
+	if (percent > 0) {
+		*size = content * percent;
+	} else if (IS_SET(before) && IS_SET(after)) {
+		*size = content - before - after;
+	}
+
+	if (IS_SET(before)) {
+		*pos = before;
+	} else if (IS_SET(after)) {
+		*pos = content - after - *size;
+	} else if (center) {
+		*pos = (content - *size) / 2;
+	}
+}
+
+static void layout_subviews(timestep_view *v) {
+	view_layout *layout = &v->layout;
+	bool native = layout->type != LAYOUT_NONE;
+	double pad_left = native ? layout->padding_left : 0;
+	double pad_top = native ? layout->padding_top : 0;
+	double content_width = VIEW_WIDTH(v) - pad_left - (native ? layout->padding_right : 0);
+	double content_height = VIEW_HEIGHT(v) - pad_top - (native ? layout->padding_bottom : 0);
+	bool linear = layout->type == LAYOUT_LINEAR;
+	bool horizontal = layout->direction == LAYOUT_HORIZONTAL;
+	double cursor = 0;
+
+	for (unsigned int i = 0; i < v->subview_count; i++) {
+		timestep_view *subview = v->subviews[i];
+		if (!subview || subview->layout.type == LAYOUT_NONE) {
+			continue;
+		}
+		if (linear && !VIEW_VISIBLE(subview)) {
+			continue;
+		}
+
+		const view_layout *sl = &subview->layout;
+		double x = VIEW_X(subview) - pad_left;
+		double y = VIEW_Y(subview) - pad_top;
+		double width = VIEW_WIDTH(subview);
+		double height = VIEW_HEIGHT(subview);
+		if (linear && horizontal) {
+			layout_axis(content_width, subview->width_percent, UNDEFINED_DIMENSION, UNDEFINED_DIMENSION, false, &width, &x);
+			layout_axis(content_height, subview->height_percent, sl->top, sl->bottom, sl->center_y, &height, &y);
+			x = cursor;
+			cursor += width + layout->spacing;
+		} else if (linear) {
+			layout_axis(content_width, subview->width_percent, sl->left, sl->right, sl->center_x, &width, &x);
+			layout_axis(content_height, subview->height_percent, UNDEFINED_DIMENSION, UNDEFINED_DIMENSION, false, &height, &y);
+			y = cursor;
+			cursor += height + layout->spacing;
+		} else {
+			layout_axis(content_width, subview->width_percent, sl->left, sl->right, sl->center_x, &width, &x);
+			layout_axis(content_height, subview->height_percent, sl->top, sl->bottom, sl->center_y, &height, &y);
+		}
+
+		VIEW_X(subview) = x + pad_left;
+		VIEW_Y(subview) = y + pad_top;
+		VIEW_WIDTH(subview) = width;
+		VIEW_HEIGHT(subview) = height;
+	}
+}
+
+static void reflow(timestep_view *v) {
+	bool resized = VIEW_WIDTH(v) != v->layout.last_width || VIEW_HEIGHT(v) != v->layout.last_height;
+	// subviews place themselves in the superview, so a change to any of them
+	// lays out its siblings too
+	bool relayout = resized || (v->needs_reflow && v->layout.type != LAYOUT_NONE);
+	for (unsigned int i = 0; i < v->subview_count && !relayout; i++) {
+		timestep_view *subview = v->subviews[i];
+		relayout = subview && subview->needs_reflow && subview->layout.type != LAYOUT_NONE;
+	}
+
+	if (relayout) {
+		layout_subviews(v);
+	}
+	v->layout.last_width = VIEW_WIDTH(v);
+	v->layout.last_height = VIEW_HEIGHT(v);
+	if (v->layout.type != LAYOUT_NONE) {
+		// views laid out from js clear the flag when js reflows them
+		v->needs_reflow = false;
+	}
+	v->subtree_needs_reflow = false;
+
+	for (unsigned int i = 0; i < v->subview_count; i++) {
+		timestep_view *subview = v->subviews[i];
+		if (subview && (subview->subtree_needs_reflow ||
+		        (relayout && subview->layout.type != LAYOUT_NONE))) {
+			reflow(subview);
+		}
+	}
+}
+
+/*
+ * Lays out the subtree of a view where it needs reflow. The size of the view
+ * itself is left to its superview.
+ */
+void timestep_layout_update(timestep_view *v) {
+	LOGFN("timestep_layout_update");
+	if (v->subtree_needs_reflow) {
+		reflow(v);
+	}
+	LOGFN("end timestep_layout_update");
+}
@@ -0,0 +1,67 @@
+/* @license
+ * This file is part of the Game Closure SDK.
+ *
+ * The Game Closure SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the Mozilla Public License v. 2.0 as published by Mozilla.
+ 
+ * The Game Closure SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Mozilla Public License v. 2.0 for more details.
+ 
+ * You should have received a copy of the Mozilla Public License v. 2.0
+ * along with the Game Closure SDK.  If not, see <http://mozilla.org/MPL/2.0/>.
+ */
+
+#ifndef TIMESTEP_LAYOUT_H
+#define TIMESTEP_LAYOUT_H
+
+#include "core/timestep/timestep.h"
+
+/*
+ * Native layout of views with a layout type other than LAYOUT_NONE. Such a
+ * view is sized by its width_percent and height_percent, fractions of its
+ * superview's size inside the padding, or stretched between its left and
+ * right or top and bottom edge distances. It is then placed by its edge
+ * distances or centered. Subviews of a linear view are stacked along its
+ * direction with its spacing between them instead, and are only placed by
+ * their edges across it. Hidden views take no space in a linear view.
+ *
+ * Layout is incremental: only views that requested reflow, their siblings
+ * and views whose superview changed size are laid out again. The layout
+ * setters request reflow themselves.
+ */
+
+void timestep_layout_init(timestep_view *v);
+void timestep_layout_request(timestep_view *v);
+void timestep_layout_request_relayout(timestep_view *v);
+void timestep_layout_update(timestep_view *v);
+
+unsigned int timestep_layout_get_type(timestep_view *v);
+void timestep_layout_set_type(timestep_view *v, unsigned int type);
+unsigned int timestep_layout_get_direction(timestep_view *v);
+void timestep_layout_set_direction(timestep_view *v, unsigned int direction);
+double timestep_layout_get_spacing(timestep_view *v);
+void timestep_layout_set_spacing(timestep_view *v, double spacing);
+double timestep_layout_get_padding_top(timestep_view *v);
+void timestep_layout_set_padding_top(timestep_view *v, double padding_top);
+double timestep_layout_get_padding_right(timestep_view *v);
+void timestep_layout_set_padding_right(timestep_view *v, double padding_right);
+double timestep_layout_get_padding_bottom(timestep_view *v);
+void timestep_layout_set_padding_bottom(timestep_view *v, double padding_bottom);
+double timestep_layout_get_padding_left(timestep_view *v);
+void timestep_layout_set_padding_left(timestep_view *v, double padding_left);
+double timestep_layout_get_top(timestep_view *v);
+void timestep_layout_set_top(timestep_view *v, double top);
+double timestep_layout_get_right(timestep_view *v);
+void timestep_layout_set_right(timestep_view *v, double right);
+double timestep_layout_get_bottom(timestep_view *v);
+void timestep_layout_set_bottom(timestep_view *v, double bottom);
+double timestep_layout_get_left(timestep_view *v);
+void timestep_layout_set_left(timestep_view *v, double left);
+bool timestep_layout_get_center_x(timestep_view *v);
+void timestep_layout_set_center_x(timestep_view *v, bool center_x);
+bool timestep_layout_get_center_y(timestep_view *v);
+void timestep_layout_set_center_y(timestep_view *v, bool center_y);
+
+#endif // TIMESTEP_LAYOUT_H
@@ -17,15 +17,108 @@
 
 #include "core/timestep/timestep_view.h"
 #include "core/timestep/timestep_image_map.h"
+#include "core/timestep/timestep_layout.h"
 #include "core/list.h"
 #include "js/js_timestep_view.h"
 #include "js/js.h"
 #include "core/log.h"
 #include "core/tealeaf_context.h"
+#include "core/texture_manager.h"
+#include "core/draw_recorder.h"
+#include <limits.h>
+#include <math.h>
+#include <string.h>
 
 static unsigned int UID = 0;
 static int add_order = 0;
 
+bool use_dirty_regions = false;
+// damage from views that were removed or hidden since the last frame
+static rect_2d pending_damage = {0, 0, -1, -1};
+static bool partial_redraw = false;
+static int last_screen_width = 0;
+static int last_screen_height = 0;
+
+bool use_bounds_culling = true;
+// context whose space the world transforms and subtree bounds are in while a
+// tree renders to it
+static context_2d *tree_ctx = NULL;
+// bounds pass of the tree being rendered, see update_subtree_bounds
+static unsigned int bounds_pass = 0;
+static unsigned int bounds_pass_count = 0;
+static unsigned int transform_version = 0;
+
+bool use_occlusion_culling = false;
+// screen rects known to be covered by what is painted after the current view
+#define MAX_OCCLUDERS 16
+static rect_2d occluders[MAX_OCCLUDERS];
+static int occluder_count = 0;
+
+// live views by uid
+static timestep_view *views_by_uid = NULL;
+// style records written by js, see timestep_view_set_style_buffer
+static double *style_buffer = NULL;
+static unsigned int style_buffer_capacity = 0;
+
+bool use_batched_jstick = false;
+// js views whose ticks are dispatched together at the end of the tick pass
+static JS_OBJECT_WRAPPER *jstick_batch = NULL;
+static unsigned int jstick_batch_count = 0;
+static unsigned int jstick_batch_size = 0;
+static bool batching_jsticks = false;
+static void (*jstick_batch_tick)(JS_OBJECT_WRAPPER*, unsigned int, double) = NULL;
+
+// largest side of a subtree cache texture
+#define CACHE_MAX_SIZE 2048
+#define HASH_SEED 14695981039346656037ULL
+
+#ifdef TIMESTEP_VIEW_SOA
+timestep_view_store view_store = {0};
+
+#define GROW_STORE_ARRAY(field, type) { \
+		type *grown = (type*)realloc(view_store.field, sizeof(type) * capacity); \
+		if (!grown) { return false; } \
+		view_store.field = grown; \
+	}
+
+// hands out a slot in view_store, growing the arrays when all are taken.
+// Returns false if they could not grow.
+static bool alloc_view_slot(unsigned int *slot) {
+	if (view_store.free_count) {
+		*slot = view_store.free_slots[--view_store.free_count];
+		return true;
+	}
+
+	if (view_store.slot_count == view_store.capacity) {
+		// arrays that did grow are kept if a later one fails
+		unsigned int capacity = view_store.capacity ? view_store.capacity * 2 : 256;
+		GROW_STORE_ARRAY(x, double);
+		GROW_STORE_ARRAY(y, double);
+		GROW_STORE_ARRAY(width, double);
+		GROW_STORE_ARRAY(height, double);
+		GROW_STORE_ARRAY(r, double);
+		GROW_STORE_ARRAY(anchor_x, double);
+		GROW_STORE_ARRAY(anchor_y, double);
+		GROW_STORE_ARRAY(offset_x, double);
+		GROW_STORE_ARRAY(offset_y, double);
+		GROW_STORE_ARRAY(scale, double);
+		GROW_STORE_ARRAY(opacity, double);
+		GROW_STORE_ARRAY(visible, bool);
+		GROW_STORE_ARRAY(world_transform, matrix_2x3);
+		GROW_STORE_ARRAY(subtree_bounds, rect_2d);
+		// every slot can be freed at once
+		GROW_STORE_ARRAY(free_slots, unsigned int);
+		view_store.capacity = capacity;
+	}
+	*slot = view_store.slot_count++;
+	return true;
+}
+
+static void free_view_slot(unsigned int slot) {
+	view_store.free_slots[view_store.free_count++] = slot;
+}
+#endif
+
 static void default_view_render(timestep_view *v, context_2d *ctx) {
 	return;
 }
@@ -36,8 +129,8 @@ static void image_view_render(timestep_view *v, context_2d *ctx) {
 
 	timestep_image_map *map = (timestep_image_map *) v->view_data;
 	if (map && map->url) {
-		float scale_x = (float)v->width / (map->margin_left + map->width + map->margin_right);
-		float scale_y = (float)v->height / (map->margin_top + map->height + map->margin_bottom);
+		float scale_x = (float)VIEW_WIDTH(v) / (map->margin_left + map->width + map->margin_right);
+		float scale_y = (float)VIEW_HEIGHT(v) / (map->margin_top + map->height + map->margin_bottom);
 		rect_2d src_rect = {map->x, map->y, map->width, map->height};
 		rect_2d dest_rect = {
 			scale_x * map->margin_left,
@@ -66,41 +159,51 @@ static void default_view_tick(timestep_view *v, double dt) {
 timestep_view *timestep_view_init() {
 	LOGFN("timestep_view_init");
 	timestep_view *v = (timestep_view*)malloc(sizeof(timestep_view));
+#ifdef TIMESTEP_VIEW_SOA
+	if (!v || !alloc_view_slot(&v->slot)) {
+		LOG("{view} ERROR: Out of memory for a view");
+		free(v);
+		return NULL;
+	}
+#endif
 	v->uid = ++UID;
+	HASH_ADD_INT(views_by_uid, uid, v);
 	v->has_jsrender = false;
 	v->has_jstick = false;
+	v->subtree_tick_count = 0;
 
 	v->superview = NULL;
 	v->subview_array_size = 4;
 	v->subviews = (timestep_view**)malloc(sizeof(timestep_view*) * v->subview_array_size);
 
 	v->subview_count = 0;
+	v->subview_tombstones = 0;
 	v->subview_index = 0;
-	v->x = 0;
-	v->y = 0;
-	v->width = UNDEFINED_DIMENSION;
-	v->height = UNDEFINED_DIMENSION;
+	VIEW_X(v) = 0;
+	VIEW_Y(v) = 0;
+	VIEW_WIDTH(v) = UNDEFINED_DIMENSION;
+	VIEW_HEIGHT(v) = UNDEFINED_DIMENSION;
 	v->width_percent = 0;
 	v->height_percent = 0;
-	v->r = 0;
-	v->anchor_x = 0;
-	v->anchor_y = 0;
-	v->offset_x = 0;
-	v->offset_y = 0;
+	VIEW_R(v) = 0;
+	VIEW_ANCHOR_X(v) = 0;
+	VIEW_ANCHOR_Y(v) = 0;
+	VIEW_OFFSET_X(v) = 0;
+	VIEW_OFFSET_Y(v) = 0;
 	v->flip_x = false;
 	v->flip_y = false;
-	v->scale = 1;
+	VIEW_SCALE(v) = 1;
 	v->clip = false;
-	v->visible = true;
+	VIEW_VISIBLE(v) = true;
 	v->z_index = 0;
 	v->dirty_z_index = false;
-	v->opacity = 1;
+	VIEW_OPACITY(v) = 1;
 	v->timestep_view_render = default_view_render;
 	v->timestep_view_tick = default_view_tick;
 	v->first_render = true;
 	v->__first_render = false;
 
-	v->needs_reflow = true;
+	timestep_layout_init(v);
 
 	v->background_color.r = 0;
 	v->background_color.g = 0;
@@ -119,12 +222,221 @@ timestep_view *timestep_view_init() {
 	v->filter_color.b = 0;
 	v->filter_color.a = 0;
 	v->filter_type = 0;
+	v->has_snapshot = false;
+
+	v->cache_as_bitmap = false;
+	v->cache_valid = false;
+	v->cache_ctx = NULL;
+	v->use_display_list = false;
+	v->display_list_valid = false;
+	v->display_list_rejected = false;
+	v->display_list = NULL;
+	// unbounded until a bounds pass visits the view
+	v->subtree_unbounded = true;
+	VIEW_SUBTREE_BOUNDS(v).x = VIEW_SUBTREE_BOUNDS(v).y = 0;
+	VIEW_SUBTREE_BOUNDS(v).width = VIEW_SUBTREE_BOUNDS(v).height = -1;
+	v->bounds_pass = 0;
+	v->occluded = false;
+	v->has_local_transform = false;
+	v->transform_version = 0;
+	v->parent_transform_version = 0;
 
 	LOGFN("end timestep_view_init");
 
 	return v;
 }
 
+/*
+ * Accessors for the js properties whose storage depends on
+ * TIMESTEP_VIEW_SOA, used by the user getters and setters of the bindings.
+ */
+#define VIEW_ACCESSORS(name, type, prop) \
+	type timestep_view_get_##name(timestep_view *v) { return prop(v); } \
+	void timestep_view_set_##name(timestep_view *v, type value) { prop(v) = value; }
+
+VIEW_ACCESSORS(x, double, VIEW_X)
+VIEW_ACCESSORS(y, double, VIEW_Y)
+VIEW_ACCESSORS(offset_x, double, VIEW_OFFSET_X)
+VIEW_ACCESSORS(offset_y, double, VIEW_OFFSET_Y)
+VIEW_ACCESSORS(r, double, VIEW_R)
+VIEW_ACCESSORS(anchor_x, double, VIEW_ANCHOR_X)
+VIEW_ACCESSORS(anchor_y, double, VIEW_ANCHOR_Y)
+VIEW_ACCESSORS(opacity, double, VIEW_OPACITY)
+VIEW_ACCESSORS(scale, double, VIEW_SCALE)
+
+double timestep_view_get_width(timestep_view *v) {
+	return VIEW_WIDTH(v);
+}
+
+void timestep_view_set_width(timestep_view *v, double width) {
+	if (VIEW_WIDTH(v) != width) {
+		VIEW_WIDTH(v) = width;
+		timestep_layout_request_relayout(v);
+	}
+}
+
+double timestep_view_get_height(timestep_view *v) {
+	return VIEW_HEIGHT(v);
+}
+
+void timestep_view_set_height(timestep_view *v, double height) {
+	if (VIEW_HEIGHT(v) != height) {
+		VIEW_HEIGHT(v) = height;
+		timestep_layout_request_relayout(v);
+	}
+}
+
+double timestep_view_get_width_percent(timestep_view *v) {
+	return v->width_percent;
+}
+
+void timestep_view_set_width_percent(timestep_view *v, double width_percent) {
+	if (v->width_percent != width_percent) {
+		v->width_percent = width_percent;
+		timestep_layout_request_relayout(v);
+	}
+}
+
+double timestep_view_get_height_percent(timestep_view *v) {
+	return v->height_percent;
+}
+
+void timestep_view_set_height_percent(timestep_view *v, double height_percent) {
+	if (v->height_percent != height_percent) {
+		v->height_percent = height_percent;
+		timestep_layout_request_relayout(v);
+	}
+}
+
+bool timestep_view_get_visible(timestep_view *v) {
+	return VIEW_VISIBLE(v);
+}
+
+void timestep_view_set_visible(timestep_view *v, bool visible) {
+	if (VIEW_VISIBLE(v) != visible) {
+		VIEW_VISIBLE(v) = visible;
+		// hidden views take no space in a linear view
+		if (v->superview && v->superview->layout.type == LAYOUT_LINEAR) {
+			timestep_layout_request(v->superview);
+		}
+	}
+}
+
+// finds a live view by its uid
+timestep_view *timestep_view_get(unsigned int uid) {
+	timestep_view *v = NULL;
+	HASH_FIND_INT(views_by_uid, &uid, v);
+	return v;
+}
+
+/*
+ * Sets the properties of the view named by the mask, taking their values in
+ * style_mask order. Does what the js setters of the properties do. Returns
+ * the number of values used.
+ */
+unsigned int timestep_view_apply_style(timestep_view *v, unsigned int mask, const double *values) {
+	const double *value = values;
+	#define APPLY_STYLE(bit, prop) if (mask & bit) { prop = *value++; }
+	APPLY_STYLE(STYLE_X, VIEW_X(v))
+	APPLY_STYLE(STYLE_Y, VIEW_Y(v))
+	if (mask & (STYLE_WIDTH | STYLE_HEIGHT)) {
+		double width = mask & STYLE_WIDTH ? *value++ : VIEW_WIDTH(v);
+		double height = mask & STYLE_HEIGHT ? *value++ : VIEW_HEIGHT(v);
+		if (width != VIEW_WIDTH(v) || height != VIEW_HEIGHT(v)) {
+			VIEW_WIDTH(v) = width;
+			VIEW_HEIGHT(v) = height;
+			timestep_layout_request_relayout(v);
+		}
+	}
+	APPLY_STYLE(STYLE_R, VIEW_R(v))
+	APPLY_STYLE(STYLE_ANCHOR_X, VIEW_ANCHOR_X(v))
+	APPLY_STYLE(STYLE_ANCHOR_Y, VIEW_ANCHOR_Y(v))
+	APPLY_STYLE(STYLE_OFFSET_X, VIEW_OFFSET_X(v))
+	APPLY_STYLE(STYLE_OFFSET_Y, VIEW_OFFSET_Y(v))
+	APPLY_STYLE(STYLE_SCALE, VIEW_SCALE(v))
+	APPLY_STYLE(STYLE_OPACITY, VIEW_OPACITY(v))
+	if (mask & STYLE_VISIBLE) {
+		timestep_view_set_visible(v, *value++ != 0);
+	}
+	if (mask & STYLE_Z_INDEX) {
+		double value_z = *value++;
+		// values that do not convert to an int leave the z index as it is
+		int z_index = value_z >= INT_MIN && value_z <= INT_MAX ? (int) value_z : v->z_index;
+		if (z_index != v->z_index) {
+			v->z_index = z_index;
+			if (v->superview) {
+				v->superview->dirty_z_index = true;
+			}
+		}
+	}
+	if (mask & STYLE_FLIP_X) {
+		v->flip_x = *value++ != 0;
+	}
+	if (mask & STYLE_FLIP_Y) {
+		v->flip_y = *value++ != 0;
+	}
+	return value - values;
+}
+
+// whether a value written by js converts to an unsigned int
+static bool is_style_word(double value) {
+	return value >= 0 && value <= UINT_MAX && value == floor(value);
+}
+
+/*
+ * Applies packed style records, see style_mask. Records of views that no
+ * longer exist are skipped, and a record whose uid or mask is not a valid
+ * integer ends the buffer. Returns the number of records applied.
+ */
+unsigned int timestep_view_apply_style_buffer(const double *records, unsigned int length) {
+	unsigned int i = 0;
+	unsigned int applied = 0;
+	while (i + 2 <= length) {
+		if (!is_style_word(records[i]) || !is_style_word(records[i + 1]) || records[i + 1] > STYLE_ALL) {
+			LOG("{view} WARNING: Dropping style records with an invalid uid or mask");
+			break;
+		}
+		timestep_view *v = timestep_view_get((unsigned int) records[i]);
+		unsigned int mask = (unsigned int) records[i + 1];
+		unsigned int count = __builtin_popcount(mask);
+		i += 2;
+		if (i + count > length) {
+			LOG("{view} WARNING: Dropping a truncated style record");
+			break;
+		}
+		if (v) {
+			timestep_view_apply_style(v, mask, records + i);
+			applied++;
+		}
+		i += count;
+	}
+	return applied;
+}
+
+/*
+ * Shares a buffer js writes style records to, so that styling many views
+ * costs no call per view. buffer[0] holds the number of values written after
+ * it, and is reset when the records are applied.
+ */
+void timestep_view_set_style_buffer(double *buffer, unsigned int capacity) {
+	style_buffer = capacity ? buffer : NULL;
+	style_buffer_capacity = capacity;
+}
+
+// applies the records in the style buffer, done before each tick and render
+void timestep_view_flush_styles() {
+	if (!style_buffer || !style_buffer[0]) {
+		return;
+	}
+
+	double length = style_buffer[0];
+	if (length > 0) {
+		unsigned int count = length < style_buffer_capacity - 1 ? (unsigned int) length : style_buffer_capacity - 1;
+		timestep_view_apply_style_buffer(style_buffer + 1, count);
+	}
+	style_buffer[0] = 0;
+}
+
 void timestep_view_set_type(timestep_view *v, unsigned int type) {
 	LOGFN("timestep_view_set_type");
 	switch (type) {
@@ -138,36 +450,519 @@ void timestep_view_set_type(timestep_view *v, unsigned int type) {
 	LOGFN("end timestep_view_set_type");
 }
 
+// applies the transform wrap_render sets up for the view's contents
+void timestep_view_apply_local_transform(timestep_view *v, matrix_2x3 *m) {
+	matrix_2x3_translate(m, VIEW_X(v) + VIEW_ANCHOR_X(v) + VIEW_OFFSET_X(v), VIEW_Y(v) + VIEW_ANCHOR_Y(v) + VIEW_OFFSET_Y(v));
+	if (VIEW_R(v)) { matrix_2x3_rotate(m, VIEW_R(v)); }
+	if (VIEW_SCALE(v) != 1) { matrix_2x3_scale(m, VIEW_SCALE(v), VIEW_SCALE(v)); }
+	matrix_2x3_translate(m, -VIEW_ANCHOR_X(v), -VIEW_ANCHOR_Y(v));
+}
+
+// rebuilds the cached local transform if the properties it is built from
+// changed, see view_transform_key for why they are compared
+static bool update_local_transform(timestep_view *v) {
+	view_transform_key key;
+	memset(&key, 0, sizeof(view_transform_key));
+	key.x = VIEW_X(v);
+	key.y = VIEW_Y(v);
+	key.r = VIEW_R(v);
+	key.anchor_x = VIEW_ANCHOR_X(v);
+	key.anchor_y = VIEW_ANCHOR_Y(v);
+	key.offset_x = VIEW_OFFSET_X(v);
+	key.offset_y = VIEW_OFFSET_Y(v);
+	key.scale = VIEW_SCALE(v);
+	if (v->has_local_transform && !memcmp(&key, &v->transform_key, sizeof(view_transform_key))) {
+		return false;
+	}
+
+	v->transform_key = key;
+	v->has_local_transform = true;
+	matrix_2x3 *m = &v->local_transform;
+	matrix_2x3_identity(m);
+	timestep_view_apply_local_transform(v, m);
+	v->local_is_identity = m->m00 == 1 && m->m01 == 0 && m->m02 == 0 && m->m10 == 0 && m->m11 == 1 && m->m12 == 0;
+	return true;
+}
+
+/*
+ * Brings the cached world transform of the view up to date. The parent
+ * version is 0 when the parent transform is not cached, in which case the
+ * product is compared to the cached one to keep the version stable.
+ */
+static void update_world_transform(timestep_view *v, const matrix_2x3 *parent, unsigned int parent_version) {
+	bool local_changed = update_local_transform(v);
+	bool cached = v->transform_version && !local_changed;
+	if (cached && parent_version && parent_version == v->parent_transform_version) {
+		return;
+	}
+
+	matrix_2x3 world;
+	matrix_2x3_multiply(parent, &v->local_transform, &world);
+	v->parent_transform_version = parent_version;
+	if (cached && !memcmp(&world, &VIEW_WORLD_TRANSFORM(v), sizeof(matrix_2x3))) {
+		return;
+	}
+
+	VIEW_WORLD_TRANSFORM(v) = world;
+	if (!++transform_version) {
+		++transform_version;
+	}
+	v->transform_version = transform_version;
+}
+
+// gets the axis aligned bounds of a view's rect under a transform
+static void transformed_bounds(const matrix_2x3 *m, timestep_view *v, rect_2d *bounds) {
+	rect_2d local = {0, 0, (float) VIEW_WIDTH(v), (float) VIEW_HEIGHT(v)};
+	float x1, y1, x2, y2, x3, y3, x4, y4;
+	matrix_2x3_multiply(m, &local, &x1, &y1, &x2, &y2, &x3, &y3, &x4, &y4);
+	bounds->x = fminf(fminf(x1, x2), fminf(x3, x4));
+	bounds->y = fminf(fminf(y1, y2), fminf(y3, y4));
+	bounds->width = fmaxf(fmaxf(x1, x2), fmaxf(x3, x4)) - bounds->x;
+	bounds->height = fmaxf(fmaxf(y1, y2), fmaxf(y3, y4)) - bounds->y;
+}
+
+// applies the flip render_contents applies before drawing the view
+static void apply_flip(timestep_view *v, matrix_2x3 *m) {
+	if (v->flip_x || v->flip_y) {
+		matrix_2x3_translate(m, v->flip_x ? VIEW_WIDTH(v) / 2 : 0, v->flip_y ? VIEW_HEIGHT(v) / 2 : 0);
+		matrix_2x3_scale(m, v->flip_x ? -1 : 1, v->flip_y ? -1 : 1);
+		matrix_2x3_translate(m, v->flip_x ? -VIEW_WIDTH(v) / 2 : 0, v->flip_y ? -VIEW_HEIGHT(v) / 2 : 0);
+	}
+}
+
+static void add_damage(rect_2d *damage, const rect_2d *r) {
+	if (r->width <= 0 || r->height <= 0) {
+		return;
+	}
+	if (damage->width < 0) {
+		*damage = *r;
+		return;
+	}
+
+	float x1 = damage->x < r->x ? damage->x : r->x;
+	float y1 = damage->y < r->y ? damage->y : r->y;
+	float x2 = damage->x + damage->width > r->x + r->width ? damage->x + damage->width : r->x + r->width;
+	float y2 = damage->y + damage->height > r->y + r->height ? damage->y + damage->height : r->y + r->height;
+	damage->x = x1;
+	damage->y = y1;
+	damage->width = x2 - x1;
+	damage->height = y2 - y1;
+}
+
+// damages everything a subtree drew last frame and forgets its state
+static void forget_subtree(timestep_view *v, rect_2d *damage) {
+	if (v->has_snapshot) {
+		add_damage(damage, &v->last_bounds);
+		v->has_snapshot = false;
+	}
+	for (unsigned int i = 0; i < v->subview_count; i++) {
+		if (v->subviews[i]) {
+			forget_subtree(v->subviews[i], damage);
+		}
+	}
+}
+
+static void take_snapshot(timestep_view *v, view_snapshot *snapshot) {
+	memset(snapshot, 0, sizeof(view_snapshot));
+	snapshot->x = VIEW_X(v);
+	snapshot->y = VIEW_Y(v);
+	snapshot->width = VIEW_WIDTH(v);
+	snapshot->height = VIEW_HEIGHT(v);
+	snapshot->r = VIEW_R(v);
+	snapshot->anchor_x = VIEW_ANCHOR_X(v);
+	snapshot->anchor_y = VIEW_ANCHOR_Y(v);
+	snapshot->offset_x = VIEW_OFFSET_X(v);
+	snapshot->offset_y = VIEW_OFFSET_Y(v);
+	snapshot->scale = VIEW_SCALE(v);
+	snapshot->opacity = VIEW_OPACITY(v);
+	snapshot->clip = v->clip;
+	snapshot->flip_x = v->flip_x;
+	snapshot->flip_y = v->flip_y;
+	snapshot->z_index = v->z_index;
+	snapshot->background_color = v->background_color;
+	snapshot->filter_color = v->filter_color;
+	snapshot->filter_type = v->filter_type;
+	snapshot->view_data = v->view_data;
+	if (v->timestep_view_render == image_view_render && v->view_data) {
+		timestep_image_map *map = (timestep_image_map *) v->view_data;
+		snapshot->image_url = map->url;
+		snapshot->image_rect[0] = map->x;
+		snapshot->image_rect[1] = map->y;
+		snapshot->image_rect[2] = map->width;
+		snapshot->image_rect[3] = map->height;
+		if (map->url) {
+			texture_2d *tex = texture_manager_find_texture(texture_manager_get(), map->url);
+			snapshot->image_texture = tex && tex->loaded ? tex->name : 0;
+		}
+	}
+}
+
+/*
+ * Compares each view against its snapshot from the last frame and adds the
+ * old and new bounds of every changed view to the damage. Changes to a view
+ * also damage its subviews, since opacity and filters are inherited. Views
+ * rendered from js are assumed to change every frame and to draw inside
+ * their bounds.
+ */
+static void collect_damage(timestep_view *v, bool parent_changed, rect_2d *damage) {
+	if (!VIEW_VISIBLE(v) || !VIEW_OPACITY(v) || VIEW_WIDTH(v) < 0 || VIEW_HEIGHT(v) < 0) {
+		forget_subtree(v, damage);
+		return;
+	}
+
+	rect_2d bounds;
+	transformed_bounds(&VIEW_WORLD_TRANSFORM(v), v, &bounds);
+
+	view_snapshot snapshot;
+	take_snapshot(v, &snapshot);
+	bool changed = parent_changed || !v->has_snapshot || memcmp(&snapshot, &v->snapshot, sizeof(view_snapshot)) ||
+	               !rect_2d_equals(&bounds, &v->last_bounds);
+
+	if (changed || (v->has_jsrender && !v->display_list_valid)) {
+		if (v->has_snapshot) {
+			add_damage(damage, &v->last_bounds);
+		}
+		add_damage(damage, &bounds);
+	}
+
+	v->snapshot = snapshot;
+	v->has_snapshot = true;
+	v->last_bounds = bounds;
+
+	for (unsigned int i = 0; i < v->subview_count; i++) {
+		if (v->subviews[i]) {
+			collect_damage(v->subviews[i], changed, damage);
+		}
+	}
+}
+
+/*
+ * Updates the world transforms of the tree and computes the bounds of what
+ * each view's subtree draws under them. Views rendered from js may draw
+ * anywhere, so they and their superviews are unbounded unless a view clips
+ * them. Also requests the reflow render_view would, since culled views are
+ * not rendered.
+ */
+static void update_subtree_bounds(timestep_view *v, const matrix_2x3 *parent, unsigned int parent_version) {
+	v->bounds_pass = bounds_pass;
+	v->subtree_unbounded = false;
+	VIEW_SUBTREE_BOUNDS(v).x = VIEW_SUBTREE_BOUNDS(v).y = 0;
+	VIEW_SUBTREE_BOUNDS(v).width = VIEW_SUBTREE_BOUNDS(v).height = -1;
+	if (!VIEW_VISIBLE(v) || !VIEW_OPACITY(v)) {
+		return;
+	}
+
+	// js may size the view on reflow
+	if (!v->__first_render && v->layout.type == LAYOUT_NONE) {
+		def_timestep_view_needs_reflow(v->js_view, true);
+	}
+	if (VIEW_WIDTH(v) < 0 || VIEW_HEIGHT(v) < 0) {
+		return;
+	}
+
+	update_world_transform(v, parent, parent_version);
+	transformed_bounds(&VIEW_WORLD_TRANSFORM(v), v, &VIEW_SUBTREE_BOUNDS(v));
+	bool unbounded = v->has_jsrender;
+
+	matrix_2x3 contents = VIEW_WORLD_TRANSFORM(v);
+	apply_flip(v, &contents);
+	// the flip depends on the size, which the version does not follow
+	unsigned int contents_version = v->flip_x || v->flip_y ? 0 : v->transform_version;
+	for (unsigned int i = 0; i < v->subview_count; i++) {
+		timestep_view *subview = v->subviews[i];
+		if (!subview) {
+			continue;
+		}
+		update_subtree_bounds(subview, &contents, contents_version);
+		unbounded = unbounded || subview->subtree_unbounded;
+		if (!v->clip) {
+			add_damage(&VIEW_SUBTREE_BOUNDS(v), &VIEW_SUBTREE_BOUNDS(subview));
+		}
+	}
+	v->subtree_unbounded = unbounded && !v->clip;
+}
+
+/*
+ * Gets the current clip of the context in the space vertices are emitted in.
+ * Onscreen clips are kept flipped for glScissor, see context_2d_setClip.
+ * The width is negative when nothing is clipped.
+ */
+static void get_vertex_clip(context_2d *ctx, rect_2d *out) {
+	*out = ctx->clipStack[ctx->mvp];
+	if (ctx->on_screen && out->width >= 0 && out->height > 0) {
+		out->y = ctx->canvas->framebuffer_height + ctx->canvas->framebuffer_offset_bottom - out->y - out->height;
+	}
+}
+
+// whether a subtree may draw inside the context and its current clip
+static bool is_subtree_visible(timestep_view *v, context_2d *ctx) {
+	const rect_2d *b = &VIEW_SUBTREE_BOUNDS(v);
+	if (v->subtree_unbounded) {
+		return true;
+	}
+	if (b->width <= 0 || b->height <= 0 || b->x + b->width <= 0 || b->y + b->height <= 0 ||
+	        b->x >= ctx->backing_width || b->y >= ctx->backing_height) {
+		return false;
+	}
+
+	rect_2d clip;
+	get_vertex_clip(ctx, &clip);
+	return clip.width < 0 || (b->x < clip.x + clip.width && b->y < clip.y + clip.height &&
+	                          b->x + b->width > clip.x && b->y + b->height > clip.y);
+}
+
+static bool rect_intersect(rect_2d *a, const rect_2d *b) {
+	float x1 = fmaxf(a->x, b->x);
+	float y1 = fmaxf(a->y, b->y);
+	float x2 = fminf(a->x + a->width, b->x + b->width);
+	float y2 = fminf(a->y + a->height, b->y + b->height);
+	a->x = x1;
+	a->y = y1;
+	a->width = x2 - x1;
+	a->height = y2 - y1;
+	return a->width > 0 && a->height > 0;
+}
+
+static bool is_occluded(const rect_2d *bounds) {
+	for (int i = 0; i < occluder_count; i++) {
+		const rect_2d *o = &occluders[i];
+		if (bounds->x >= o->x && bounds->y >= o->y &&
+		        bounds->x + bounds->width <= o->x + o->width && bounds->y + bounds->height <= o->y + o->height) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// keeps the largest occluders once the list is full
+static void add_occluder(const rect_2d *r) {
+	if (occluder_count < MAX_OCCLUDERS) {
+		occluders[occluder_count++] = *r;
+		return;
+	}
+
+	int smallest = 0;
+	for (int i = 1; i < MAX_OCCLUDERS; i++) {
+		if (occluders[i].width * occluders[i].height < occluders[smallest].width * occluders[smallest].height) {
+			smallest = i;
+		}
+	}
+	if (r->width * r->height > occluders[smallest].width * occluders[smallest].height) {
+		occluders[smallest] = *r;
+	}
+}
+
+// whether the view covers its rect with opaque pixels when drawn at full opacity
+static bool is_view_opaque(timestep_view *v) {
+	if (v->background_color.a >= 1) {
+		return true;
+	}
+
+	if (v->timestep_view_render == image_view_render && !v->has_jsrender && v->view_data) {
+		timestep_image_map *map = (timestep_image_map *) v->view_data;
+		if (!map->url || map->margin_top || map->margin_right || map->margin_bottom || map->margin_left) {
+			return false;
+		}
+		texture_2d *tex = texture_manager_get_texture(texture_manager_get(), map->url);
+		return tex && tex->loaded && !tex->failed && !tex->is_text && (tex->num_channels == 1 || tex->num_channels == 3);
+	}
+	return false;
+}
+
+/*
+ * Visits the tree from the top of the paint order down, marking the subtrees
+ * that lie inside an opaque view painted after them. Needs the subtree bounds.
+ * alpha is the global alpha the view is drawn with and clip the screen rect
+ * its drawing is clipped to. Cached subtrees are drawn from a filtered texture
+ * whose edges may blend, so they do not occlude.
+ */
+static void update_occlusion(timestep_view *v, float alpha, rect_2d clip, bool occludes) {
+	v->occluded = false;
+	if (!VIEW_VISIBLE(v) || !VIEW_OPACITY(v) || VIEW_WIDTH(v) < 0 || VIEW_HEIGHT(v) < 0) {
+		return;
+	}
+	if (!v->subtree_unbounded && is_occluded(&VIEW_SUBTREE_BOUNDS(v))) {
+		v->occluded = true;
+		return;
+	}
+
+	const matrix_2x3 *m = &VIEW_WORLD_TRANSFORM(v);
+	alpha *= VIEW_OPACITY(v);
+	rect_2d bounds;
+	transformed_bounds(m, v, &bounds);
+	if (v->clip) {
+		rect_intersect(&clip, &bounds);
+	}
+	occludes = occludes && !v->cache_as_bitmap;
+
+	for (unsigned int i = v->subview_count; i-- > 0;) {
+		if (v->subviews[i]) {
+			update_occlusion(v->subviews[i], alpha, clip, occludes);
+		}
+	}
+
+	// the view paints itself below its subviews
+	if (occludes && alpha >= 1 && m->m01 == 0 && m->m10 == 0 && is_view_opaque(v) && rect_intersect(&bounds, &clip)) {
+		// only whole pixels are surely covered
+		float x2 = floorf(bounds.x + bounds.width);
+		float y2 = floorf(bounds.y + bounds.height);
+		bounds.x = ceilf(bounds.x);
+		bounds.y = ceilf(bounds.y);
+		bounds.width = x2 - bounds.x;
+		bounds.height = y2 - bounds.y;
+		if (bounds.width > 0 && bounds.height > 0) {
+			add_occluder(&bounds);
+		}
+	}
+}
+
+static void render_root(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts);
+static void render_view(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts);
+
 void timestep_view_wrap_render(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts) {
+	if (v->superview || partial_redraw) {
+		render_view(v, ctx, js_ctx, js_opts);
+		return;
+	}
+
+	// trees may render other trees from js
+	context_2d *prev_tree_ctx = tree_ctx;
+	unsigned int prev_bounds_pass = bounds_pass;
+	bounds_pass = ++bounds_pass_count;
+	timestep_view_flush_styles();
+	timestep_layout_update(v);
+	update_subtree_bounds(v, context_2d_get_model_view(ctx), 0);
+	if (use_occlusion_culling) {
+		rect_2d clip = {0, 0, (float) ctx->backing_width, (float) ctx->backing_height};
+		rect_2d ctx_clip;
+		get_vertex_clip(ctx, &ctx_clip);
+		if (ctx_clip.width >= 0) {
+			rect_intersect(&clip, &ctx_clip);
+		}
+		occluder_count = 0;
+		update_occlusion(v, ctx->globalAlpha[ctx->mvp], clip, true);
+	}
+	tree_ctx = ctx;
+	render_root(v, ctx, js_ctx, js_opts);
+	tree_ctx = prev_tree_ctx;
+	bounds_pass = prev_bounds_pass;
+}
+
+static void render_root(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts) {
+	// only the onscreen tree tracks damage
+	if (!ctx->on_screen) {
+		render_view(v, ctx, js_ctx, js_opts);
+		return;
+	}
+
+	if (!use_dirty_regions) {
+		if (ctx->preserve_contents) {
+			// the clear of this frame was skipped
+			ctx->preserve_contents = false;
+			context_2d_clear(ctx);
+		}
+		render_view(v, ctx, js_ctx, js_opts);
+		return;
+	}
+
+	rect_2d damage = pending_damage;
+	pending_damage.x = pending_damage.y = 0;
+	pending_damage.width = pending_damage.height = -1;
+	collect_damage(v, false, &damage);
+
+	// the first frame and frames after a resize are drawn in full
+	bool resized = ctx->width != last_screen_width || ctx->height != last_screen_height;
+	if (!ctx->preserve_contents || resized) {
+		if (ctx->preserve_contents) {
+			// the clear of this frame was skipped
+			ctx->preserve_contents = false;
+			context_2d_clear(ctx);
+		}
+		ctx->preserve_contents = true;
+		last_screen_width = ctx->width;
+		last_screen_height = ctx->height;
+		render_view(v, ctx, js_ctx, js_opts);
+		return;
+	}
+
+	if (damage.width <= 0 || damage.height <= 0) {
+		return;
+	}
+
+	// snap outwards to whole pixels so that no partially covered pixel is left stale
+	float x2 = ceilf(damage.x + damage.width);
+	float y2 = ceilf(damage.y + damage.height);
+	damage.x = floorf(damage.x);
+	damage.y = floorf(damage.y);
+	damage.width = x2 - damage.x;
+	damage.height = y2 - damage.y;
+
+	partial_redraw = true;
+	context_2d_save(ctx);
+	// the damage is in device space, the tree is drawn under the root transform
+	matrix_2x3 root_transform = *context_2d_get_model_view(ctx);
+	context_2d_loadIdentity(ctx);
+	context_2d_setClip(ctx, damage);
+	context_2d_clearRect(ctx, &damage);
+	context_2d_setTransform(ctx, &root_transform);
+	render_view(v, ctx, js_ctx, js_opts);
+	context_2d_restore(ctx);
+	partial_redraw = false;
+}
+
+static void render_contents(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts);
+static bool render_display_list(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts);
+static bool render_cached(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts);
+
+static void render_view(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts) {
 	LOGFN("timestep_view_wrap_render");
-	if (!v->visible || !v->opacity) { return; }
+	if (!VIEW_VISIBLE(v) || !VIEW_OPACITY(v)) { return; }
 
-	if (!v->__first_render) {
+	// views attached since the bounds pass are neither culled nor reflowed yet
+	if (ctx == tree_ctx && v->bounds_pass == bounds_pass) {
+		// the bounds pass requested the reflow
+		if ((use_bounds_culling && !is_subtree_visible(v, ctx)) || (use_occlusion_culling && v->occluded)) {
+			return;
+		}
+	} else if (!v->__first_render && v->layout.type == LAYOUT_NONE) {
 		def_timestep_view_needs_reflow(v->js_view, true);
 	}
 
 	if (v->dirty_z_index) {
 		v->dirty_z_index = false;
 		timestep_view_sort_subviews(v);
+	} else if (v->subview_tombstones) {
+		timestep_view_compact_subviews(v);
 	}
-	if (v->width < 0 || v->height < 0) {
+	if (VIEW_WIDTH(v) < 0 || VIEW_HEIGHT(v) < 0) {
 		return;
 	}
 
 	context_2d_save(ctx);
-	context_2d_translate(ctx, v->x + v->anchor_x + v->offset_x, v->y + v->anchor_y + v->offset_y);
+	// views at the origin skip the multiply
+	update_local_transform(v);
+	if (!v->local_is_identity) {
+		context_2d_transform(ctx, &v->local_transform);
+	}
 
-	if (v->r) { context_2d_rotate(ctx, v->r); }
-	if (v->scale != 1) { context_2d_scale(ctx, v->scale, v->scale); }
-	if (v->opacity != 1) {
+	if (VIEW_OPACITY(v) != 1) {
 		double alpha = context_2d_getGlobalAlpha(ctx);
-		context_2d_setGlobalAlpha(ctx, alpha * v->opacity);
+		context_2d_setGlobalAlpha(ctx, alpha * VIEW_OPACITY(v));
 	}
 
-	context_2d_translate(ctx, -v->anchor_x, -v->anchor_y);
+	if (!v->cache_as_bitmap || !render_cached(v, ctx, js_ctx, js_opts)) {
+		render_contents(v, ctx, js_ctx, js_opts);
+	}
+
+	context_2d_restore(ctx);
 
+	LOGFN("end timestep_view_wrap_render");
+}
+
+// renders the view and its subviews in the view's space
+static void render_contents(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts) {
 	if (v->clip) {
-		rect_2d r = {0, 0, v->width, v->height};
+		rect_2d r = {0, 0, VIEW_WIDTH(v), VIEW_HEIGHT(v)};
 		context_2d_setClip(ctx, r);
 	}
 
@@ -184,36 +979,41 @@ void timestep_view_wrap_render(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAP
 	if (v->background_color.a > 0) {
 		//LOG("render %i with background %f %f %f %f", v->uid, v->background_color.r, v->background_color.g, v->background_color.b, v->background_color.a);
 
-		rect_2d r = {0, 0, v->width, v->height};
+		rect_2d r = {0, 0, VIEW_WIDTH(v), VIEW_HEIGHT(v)};
 		context_2d_fillRect(ctx, &r, &v->background_color, source_over);
 	}
 
 
 	if (v->flip_x || v->flip_y) {
 			context_2d_translate(ctx,
-					v->flip_x ? v->width / 2 : 0,
-					v->flip_y ? v->height / 2 : 0);
+					v->flip_x ? VIEW_WIDTH(v) / 2 : 0,
+					v->flip_y ? VIEW_HEIGHT(v) / 2 : 0);
 
 			context_2d_scale(ctx,
 					v->flip_x ? -1 : 1,
 					v->flip_y ? -1 : 1);
 
 			context_2d_translate(ctx,
-					v->flip_x ? -v->width / 2 : 0,
-					v->flip_y ? -v->height / 2 : 0);
+					v->flip_x ? -VIEW_WIDTH(v) / 2 : 0,
+					v->flip_y ? -VIEW_HEIGHT(v) / 2 : 0);
 	}
 
 	JS_OBJECT_WRAPPER js_viewport;
 	if (v->has_jsrender) {
 		js_viewport = def_get_viewport(js_opts);
-		def_timestep_view_render(v->js_view, js_ctx, js_opts);
+		if (!v->use_display_list || !render_display_list(v, ctx, js_ctx, js_opts)) {
+			def_timestep_view_render(v->js_view, js_ctx, js_opts);
+		}
 	} else {
 		v->timestep_view_render(v, ctx);
 	}
 
+	// js renders may remove subviews as they are drawn
 	for (unsigned int i = 0; i < v->subview_count; i++) {
 		timestep_view *subview = v->subviews[i];
-		timestep_view_wrap_render(subview, ctx, js_ctx, js_opts);
+		if (subview) {
+			render_view(subview, ctx, js_ctx, js_opts);
+		}
 	}
 
 
@@ -231,12 +1031,273 @@ void timestep_view_wrap_render(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAP
 	if (v->has_jsrender) {
 		def_restore_viewport(js_opts, js_viewport);
 	}
+}
 
-	context_2d_restore(ctx);
+static void hash_bytes(uint64_t *hash, const void *data, size_t bytes) {
+	const unsigned char *p = (const unsigned char *) data;
+	for (size_t i = 0; i < bytes; i++) {
+		*hash = (*hash ^ p[i]) * 1099511628211ULL;
+	}
+}
 
-	LOGFN("end timestep_view_wrap_render");
+static void hash_view(uint64_t *hash, timestep_view *v, view_snapshot *snapshot) {
+	hash_bytes(hash, snapshot, sizeof(view_snapshot));
+	hash_bytes(hash, &v->timestep_view_render, sizeof(v->timestep_view_render));
+}
+
+/*
+ * Walks the subviews of a cached view the way render_contents would, hashing
+ * the state of every view that draws and adding what they draw to the bounds,
+ * in the space of the cached view. The bounds are NULL below a clipping view.
+ * Views rendered from js draw to the js context, so their subtrees cannot be
+ * cached.
+ */
+static bool scan_subviews(timestep_view *v, const matrix_2x3 *m, uint64_t *hash, rect_2d *bounds) {
+	matrix_2x3 contents = *m;
+	apply_flip(v, &contents);
+
+	for (unsigned int i = 0; i < v->subview_count; i++) {
+		timestep_view *subview = v->subviews[i];
+		if (!subview) {
+			continue;
+		}
+		bool drawn = VIEW_VISIBLE(subview) && VIEW_OPACITY(subview);
+		hash_bytes(hash, &subview->uid, sizeof(subview->uid));
+		hash_bytes(hash, &drawn, sizeof(drawn));
+		if (!drawn) {
+			continue;
+		}
+
+		if (subview->has_jsrender) {
+			return false;
+		}
+		if (!subview->__first_render && subview->layout.type == LAYOUT_NONE) {
+			def_timestep_view_needs_reflow(subview->js_view, true);
+		}
+		if (subview->dirty_z_index) {
+			subview->dirty_z_index = false;
+			timestep_view_sort_subviews(subview);
+		} else if (subview->subview_tombstones) {
+			timestep_view_compact_subviews(subview);
+		}
+		if (VIEW_WIDTH(subview) < 0 || VIEW_HEIGHT(subview) < 0) {
+			continue;
+		}
+
+		view_snapshot snapshot;
+		take_snapshot(subview, &snapshot);
+		hash_view(hash, subview, &snapshot);
+
+		matrix_2x3 sm;
+		update_local_transform(subview);
+		matrix_2x3_multiply(&contents, &subview->local_transform, &sm);
+		if (bounds) {
+			rect_2d r;
+			transformed_bounds(&sm, subview, &r);
+			add_damage(bounds, &r);
+		}
+
+		if (!scan_subviews(subview, &sm, hash, subview->clip ? NULL : bounds)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void release_cache(timestep_view *v) {
+	if (v->cache_ctx) {
+		context_2d_delete(v->cache_ctx);
+		v->cache_ctx = NULL;
+	}
+	v->cache_valid = false;
+}
+
+/*
+ * Draws the view's contents from its cache, rendering them into the cache
+ * first if the subtree changed since. The cache is rendered at the scale the
+ * view is drawn at. Returns false if the subtree cannot be cached.
+ */
+static bool render_cached(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts) {
+	// the view's own transform and opacity are applied to the cached quad
+	view_snapshot snapshot;
+	take_snapshot(v, &snapshot);
+	snapshot.x = snapshot.y = snapshot.r = 0;
+	snapshot.anchor_x = snapshot.anchor_y = 0;
+	snapshot.offset_x = snapshot.offset_y = 0;
+	snapshot.scale = snapshot.opacity = 1;
+
+	uint64_t hash = HASH_SEED;
+	hash_view(&hash, v, &snapshot);
+	rect_2d bounds = {0, 0, (float) VIEW_WIDTH(v), (float) VIEW_HEIGHT(v)};
+	matrix_2x3 identity;
+	matrix_2x3_identity(&identity);
+	if (v->has_jsrender || !scan_subviews(v, &identity, &hash, v->clip ? NULL : &bounds)) {
+		release_cache(v);
+		return false;
+	}
+
+	const matrix_2x3 *mv = context_2d_get_model_view(ctx);
+	float scale = fmaxf(hypotf(mv->m00, mv->m10), hypotf(mv->m01, mv->m11));
+	// keep a cache that is at most twice as sharp as needed, so that scaling
+	// the view does not render it again every frame
+	if (v->cache_valid && scale <= v->cache_scale && scale * 2 >= v->cache_scale) {
+		scale = v->cache_scale;
+	}
+	float size = fmaxf(bounds.width, bounds.height) * scale;
+	if (size > CACHE_MAX_SIZE) {
+		scale *= CACHE_MAX_SIZE / size;
+	}
+	int width = (int) ceilf(bounds.width * scale);
+	int height = (int) ceilf(bounds.height * scale);
+	if (width <= 0 || height <= 0) {
+		return true;
+	}
+
+	if (!v->cache_valid || hash != v->cache_hash || scale != v->cache_scale || !rect_2d_equals(&bounds, &v->cache_bounds)) {
+		context_2d *cache = v->cache_ctx;
+		if (cache && (cache->backing_width < width || cache->backing_height < height)) {
+			release_cache(v);
+			cache = NULL;
+		}
+		if (!cache) {
+			texture_2d *tex = texture_manager_new_texture(texture_manager_get(), width, height);
+			if (!tex) {
+				return false;
+			}
+			cache = v->cache_ctx = context_2d_new(tealeaf_canvas_get(), tex->url, tex->name);
+		}
+
+		context_2d_clear(cache);
+		context_2d_save(cache);
+		context_2d_scale(cache, scale, scale);
+		context_2d_translate(cache, -bounds.x, -bounds.y);
+		render_contents(v, cache, js_ctx, js_opts);
+		context_2d_restore(cache);
+
+		v->cache_valid = true;
+		v->cache_hash = hash;
+		v->cache_bounds = bounds;
+		v->cache_scale = scale;
+	}
+
+	// filters were applied when the cache was rendered
+	rgba filter_color = ctx->filter_color;
+	int filter_type = ctx->filter_type;
+	context_2d_clear_filters(ctx);
+
+	rect_2d src_rect = {0, 0, (float) width, (float) height};
+	rect_2d dest_rect = {bounds.x, bounds.y, width / scale, height / scale};
+	context_2d_drawImage(ctx, 0, v->cache_ctx->url, &src_rect, &dest_rect, 0);
+
+	ctx->filter_color = filter_color;
+	ctx->filter_type = filter_type;
+	return true;
+}
+
+/*
+ * Draws a js rendered view from its display list, recording the list from the
+ * js render first if it is stale. Returns false if the view has to be rendered
+ * from js, which is the case while a frame is being captured and after the
+ * render drew something a list cannot replay: draws to other contexts, clips
+ * or clears.
+ */
+static bool render_display_list(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts) {
+	if (v->display_list_rejected || draw_recorder_recording) {
+		return false;
+	}
+
+	const matrix_2x3 *mv = context_2d_get_model_view(ctx);
+	float alpha = context_2d_getGlobalAlpha(ctx);
+	// js renders usually fill the view
+	if (VIEW_WIDTH(v) != v->display_list_width || VIEW_HEIGHT(v) != v->display_list_height) {
+		v->display_list_valid = false;
+	}
+
+	if (v->display_list_valid) {
+		matrix_2x3 transform;
+		matrix_2x3_multiply(mv, &v->display_list_inverse, &transform);
+		draw_recording_replay_into(v->display_list, ctx, &transform, alpha / v->display_list_alpha);
+		return true;
+	}
+
+	if (!v->display_list) {
+		v->display_list = draw_recording_new();
+	} else {
+		draw_recording_clear(v->display_list);
+	}
+	rect_2d clip = ctx->clipStack[ctx->mvp];
+	draw_recorder_start(v->display_list);
+	def_timestep_view_render(v->js_view, js_ctx, js_opts);
+	draw_recorder_stop();
+
+	if (!draw_recording_is_complete(v->display_list)) {
+		// textures still loading, record again next frame
+		return true;
+	}
+
+	if (alpha > 0 && matrix_2x3_invert(mv, &v->display_list_inverse) &&
+	        draw_recording_is_local(v->display_list, ctx, &clip)) {
+		v->display_list_valid = true;
+		v->display_list_alpha = alpha;
+		v->display_list_width = VIEW_WIDTH(v);
+		v->display_list_height = VIEW_HEIGHT(v);
+	} else {
+		v->display_list_rejected = alpha > 0;
+		draw_recording_free(v->display_list);
+		v->display_list = NULL;
+	}
+	return true;
 }
 
+static void release_display_list(timestep_view *v) {
+	draw_recording_free(v->display_list);
+	v->display_list = NULL;
+	v->display_list_valid = false;
+	v->display_list_rejected = false;
+}
+
+/*
+ * Records what the js render of the view draws and replays it natively in
+ * later frames, under the view's transform and opacity of that frame, until
+ * timestep_view_invalidate_display_list or a resize marks it stale. The js
+ * render is not called while the list is replayed, so changes it would make
+ * to the js viewport of its subviews are skipped too.
+ */
+void timestep_view_set_display_list(timestep_view *v, bool use_display_list) {
+	v->use_display_list = use_display_list;
+	if (!use_display_list) {
+		release_display_list(v);
+	}
+}
+
+// makes the next render of the view record its display list again
+void timestep_view_invalidate_display_list(timestep_view *v) {
+	v->display_list_valid = false;
+	v->display_list_rejected = false;
+}
+
+/*
+ * Renders the view's subtree into a texture once and draws it as a single
+ * quad until the subtree changes. Changes are found by hashing the state of
+ * the subtree every frame, except for the contents of offscreen canvases the
+ * subtree draws, see timestep_view_invalidate_cache. Opacity applies to the
+ * subtree as a whole when cached.
+ */
+void timestep_view_set_cache_as_bitmap(timestep_view *v, bool cache_as_bitmap) {
+	v->cache_as_bitmap = cache_as_bitmap;
+	if (!cache_as_bitmap) {
+		release_cache(v);
+	}
+}
+
+// forces the caches of the view and its superviews to render again
+void timestep_view_invalidate_cache(timestep_view *v) {
+	for (; v; v = v->superview) {
+		v->cache_valid = false;
+	}
+}
+
+
 void timestep_view_render(timestep_view *v) {
 	// do background color???
 
@@ -244,20 +1305,95 @@ void timestep_view_render(timestep_view *v) {
 
 
 
-void timestep_view_wrap_tick(timestep_view *v, double dt) {
-	LOGFN("timestep_view_wrap_tick");
+// whether the view has a tick of its own
+static bool view_ticks(timestep_view *v) {
+	return v->has_jstick || v->timestep_view_tick != default_view_tick;
+}
+
+// adds to the tick counts of the view and its superviews
+static void add_tick_count(timestep_view *v, int count) {
+	for (; v && count; v = v->superview) {
+		v->subtree_tick_count += count;
+	}
+}
+
+void timestep_view_set_has_jstick(timestep_view *v, bool has_jstick) {
+	bool ticked = view_ticks(v);
+	v->has_jstick = has_jstick;
+	add_tick_count(v, (int) view_ticks(v) - (int) ticked);
+}
+
+void timestep_view_set_tick(timestep_view *v, void (*tick)(timestep_view*, double)) {
+	bool ticked = view_ticks(v);
+	v->timestep_view_tick = tick ? tick : default_view_tick;
+	add_tick_count(v, (int) view_ticks(v) - (int) ticked);
+}
+
+void timestep_view_set_tick_batch(void (*tick_batch)(JS_OBJECT_WRAPPER*, unsigned int, double)) {
+	jstick_batch_tick = tick_batch;
+}
+
+// adds the view to the batch, returns false if the batch could not grow
+static bool batch_jstick(timestep_view *v) {
+	if (jstick_batch_count == jstick_batch_size) {
+		unsigned int size = jstick_batch_size ? jstick_batch_size * 2 : 64;
+		JS_OBJECT_WRAPPER *batch = (JS_OBJECT_WRAPPER*)realloc(jstick_batch, sizeof(JS_OBJECT_WRAPPER) * size);
+		if (!batch) {
+			return false;
+		}
+		jstick_batch = batch;
+		jstick_batch_size = size;
+	}
+	jstick_batch[jstick_batch_count++] = v->js_view;
+	return true;
+}
+
+// ticks the views of the subtree in tree order, skipping subtrees that do not tick
+static void tick_subtree(timestep_view *v, double dt) {
+	if (v->subview_tombstones) {
+		timestep_view_compact_subviews(v);
+	}
 	if (v->has_jstick) {
-		def_timestep_view_tick(v->js_view, dt);
-	} else {
+		if (!batching_jsticks || !batch_jstick(v)) {
+			def_timestep_view_tick(v->js_view, dt);
+		}
+	} else if (v->timestep_view_tick != default_view_tick) {
 		v->timestep_view_tick(v, dt);
 	}
 
 	for (unsigned int i = 0; i < v->subview_count; i++) {
 		timestep_view *subview = v->subviews[i];
-		if (subview) {
-			timestep_view_wrap_tick(subview, dt);
+		if (subview && subview->subtree_tick_count) {
+			tick_subtree(subview, dt);
 		}
 	}
+}
+
+/*
+ * Ticks the views of the subtree in tree order. Subtrees without a view that
+ * ticks are skipped, so they cost nothing per frame. With use_batched_jstick
+ * and a batch tick registered by the bindings, the js ticks are collected and
+ * run in one call once the walk is done, so views removed by an earlier js
+ * tick of the batch are still ticked.
+ */
+void timestep_view_wrap_tick(timestep_view *v, double dt) {
+	LOGFN("timestep_view_wrap_tick");
+	timestep_view_flush_styles();
+	if (!v->subtree_tick_count) {
+		return;
+	}
+
+	if (use_batched_jstick && jstick_batch_tick && !batching_jsticks) {
+		batching_jsticks = true;
+		jstick_batch_count = 0;
+		tick_subtree(v, dt);
+		batching_jsticks = false;
+		if (jstick_batch_count) {
+			jstick_batch_tick(jstick_batch, jstick_batch_count, dt);
+		}
+	} else {
+		tick_subtree(v, dt);
+	}
 
 	// TODO: needs repaint?
 	LOGFN("end timestep_view_wrap_tick");
@@ -303,6 +1439,7 @@ static int timestep_view_comparator(const void *a, const void *b) {
 
 void timestep_view_sort_subviews(timestep_view *v) {
 	LOGFN("timestep_view_sort_subviews");
+	timestep_view_compact_subviews(v);
 	qsort(v->subviews, v->subview_count, sizeof(timestep_view*), timestep_view_comparator);
 	for (unsigned int i = 0; i < v->subview_count; i++) {
 		v->subviews[i]->subview_index = i;
@@ -310,6 +1447,35 @@ void timestep_view_sort_subviews(timestep_view *v) {
 	LOGFN("end timestep_view_sort_subviews");
 }
 
+// squeezes the tombstones of removed subviews out of the subview array
+void timestep_view_compact_subviews(timestep_view *v) {
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < v->subview_count; i++) {
+		timestep_view *subview = v->subviews[i];
+		if (subview) {
+			subview->subview_index = count;
+			v->subviews[count++] = subview;
+		}
+	}
+	v->subview_count = count;
+	v->subview_tombstones = 0;
+}
+
+// finds where a subview goes in the sorted subviews, which have no tombstones
+static unsigned int find_subview_position(timestep_view *v, timestep_view *subview) {
+	unsigned int lo = 0;
+	unsigned int hi = v->subview_count;
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+		if (timestep_view_comparator(&v->subviews[mid], &subview) <= 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
 bool timestep_view_add_subview(timestep_view *v, timestep_view *subview) {
 	LOGFN("timestep_view_add_subview");
 	if (subview->superview == v) {
@@ -319,17 +1485,42 @@ bool timestep_view_add_subview(timestep_view *v, timestep_view *subview) {
 		timestep_view_remove_subview(subview->superview, subview);
 	}
 	if (v->subview_array_size <= v->subview_count) {
-		v->subview_array_size *= 2;
-		v->subviews = (timestep_view**)realloc(v->subviews, sizeof(timestep_view*) * v->subview_array_size);
+		if (v->subview_tombstones) {
+			timestep_view_compact_subviews(v);
+		} else {
+			v->subview_array_size *= 2;
+			v->subviews = (timestep_view**)realloc(v->subviews, sizeof(timestep_view*) * v->subview_array_size);
+		}
 	}
 
 	//LOG(">>> adding to view %i subview %i; current size %i", v->uid, subview->uid, v->subview_count);
-	subview->subview_index = v->subview_count;
-	v->subviews[v->subview_count++] = subview;
 	subview->superview = v;
 	subview->added_at = ++add_order;
-	subview->needs_reflow = true;
-	v->dirty_z_index = true;
+	add_tick_count(v, subview->subtree_tick_count);
+	timestep_layout_request(subview);
+
+	// subviews are usually added on top of their siblings. An unsorted array
+	// is sorted before the next render, so the subview is just appended.
+	unsigned int index = v->subview_count;
+	if (!v->dirty_z_index) {
+		unsigned int last = v->subview_count;
+		while (last > 0 && !v->subviews[last - 1]) {
+			last--;
+		}
+		if (last > 0 && timestep_view_comparator(&v->subviews[last - 1], &subview) > 0) {
+			if (v->subview_tombstones) {
+				timestep_view_compact_subviews(v);
+			}
+			index = find_subview_position(v, subview);
+		}
+	}
+
+	memmove(&v->subviews[index + 1], &v->subviews[index], sizeof(timestep_view*) * (v->subview_count - index));
+	v->subviews[index] = subview;
+	v->subview_count++;
+	for (unsigned int i = index; i < v->subview_count; ++i) {
+		v->subviews[i]->subview_index = i;
+	}
 
 	js_object_wrapper_root(&subview->pin_view, subview->js_view);
 
@@ -346,16 +1537,21 @@ bool timestep_view_remove_subview(timestep_view *v, timestep_view *subview) {
 	//LOG("removing %i from %i", subview->uid, v->uid);
 	//LOG("count %i index %i", count, index);
 	if (index < count && *pos == subview) {
-		timestep_view **to = pos;
-		timestep_view **from = to + 1;
-		int bytes = sizeof(timestep_view*) * (count - index - 1);
-		memmove(to, from, bytes);
-		v->subview_count--;
-		for (unsigned int i = index; i < count - 1; ++i) {
-			v->subviews[i]->subview_index = i;
+		// leave a tombstone rather than moving the following subviews, the
+		// array is compacted when it is next walked
+		*pos = NULL;
+		v->subview_tombstones++;
+		while (v->subview_count && !v->subviews[v->subview_count - 1]) {
+			v->subview_count--;
+			v->subview_tombstones--;
 		}
 		subview->superview = NULL;
+		add_tick_count(v, -(int) subview->subtree_tick_count);
+		if (v->layout.type == LAYOUT_LINEAR) {
+			timestep_layout_request(v);
+		}
 		js_object_wrapper_delete(&subview->pin_view);
+		forget_subtree(subview, &pending_damage);
 		LOGFN("end timestep_view_remove_subview");
 		return true;
 	} else {
@@ -403,6 +1599,9 @@ void timestep_view_delete(timestep_view *v) {
 	// Disconnect all subviews
 	for (unsigned int i = 0, count = v->subview_count; i < count; ++i) {
 		timestep_view *subview = v->subviews[i];
+		if (!subview) {
+			continue;
+		}
 
 		// Stomp.
 		subview->superview = NULL;
@@ -411,12 +1610,26 @@ void timestep_view_delete(timestep_view *v) {
 		js_object_wrapper_delete(&subview->pin_view);
 	}
 
+	release_cache(v);
+	release_display_list(v);
+	HASH_DEL(views_by_uid, v);
 	js_object_wrapper_delete(&v->map_ref);
 	js_object_wrapper_delete(&v->pin_view);
+#ifdef TIMESTEP_VIEW_SOA
+	free_view_slot(v->slot);
+#endif
 	free(v);
 }
 
 CEXPORT void timestep_view_shutdown() {
 	UID = 0;
 	add_order = 0;
+	HASH_CLEAR(hh, views_by_uid);
+	style_buffer = NULL;
+	style_buffer_capacity = 0;
+	free(jstick_batch);
+	jstick_batch = NULL;
+	jstick_batch_count = jstick_batch_size = 0;
+	pending_damage.x = pending_damage.y = 0;
+	pending_damage.width = pending_damage.height = -1;
 }
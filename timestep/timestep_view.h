@@ -18,13 +18,99 @@
 
 #include "core/timestep/timestep.h"
 
+// Redraw only the regions of the onscreen context whose views changed since the
+// last frame. The platform must preserve the backbuffer between frames and the
+// contents of offscreen canvases drawn by views are assumed not to change.
+extern bool use_dirty_regions;
+// Skip subtrees that lie outside the context or its clip. Views are assumed
+// to draw inside their bounds, except for views rendered from js.
+extern bool use_bounds_culling;
+// Skip subtrees that are covered by opaque views painted after them. Views with
+// an opaque background color, or image views filled with an image without
+// alpha, are opaque when drawn at full opacity without rotation.
+extern bool use_occlusion_culling;
+// Collect the js ticks of a tick pass and dispatch them in one call to the
+// batch tick of the bindings, after the native ticks of the pass. Has no
+// effect until the bindings register one with timestep_view_set_tick_batch.
+extern bool use_batched_jstick;
+
+/*
+ * Properties of a style record, in the order their values follow the mask.
+ * A record is the view's uid, the mask and one value per bit set in it.
+ */
+enum style_mask {
+	STYLE_X = 1 << 0,
+	STYLE_Y = 1 << 1,
+	STYLE_WIDTH = 1 << 2,
+	STYLE_HEIGHT = 1 << 3,
+	STYLE_R = 1 << 4,
+	STYLE_ANCHOR_X = 1 << 5,
+	STYLE_ANCHOR_Y = 1 << 6,
+	STYLE_OFFSET_X = 1 << 7,
+	STYLE_OFFSET_Y = 1 << 8,
+	STYLE_SCALE = 1 << 9,
+	STYLE_OPACITY = 1 << 10,
+	STYLE_VISIBLE = 1 << 11,
+	STYLE_Z_INDEX = 1 << 12,
+	STYLE_FLIP_X = 1 << 13,
+	STYLE_FLIP_Y = 1 << 14,
+	STYLE_ALL = (1 << 15) - 1
+};
+
 timestep_view *timestep_view_init();
+timestep_view *timestep_view_get(unsigned int uid);
+unsigned int timestep_view_apply_style(timestep_view *v, unsigned int mask, const double *values);
+unsigned int timestep_view_apply_style_buffer(const double *records, unsigned int length);
+void timestep_view_set_style_buffer(double *buffer, unsigned int capacity);
+void timestep_view_flush_styles();
+
+double timestep_view_get_x(timestep_view *v);
+void timestep_view_set_x(timestep_view *v, double x);
+double timestep_view_get_y(timestep_view *v);
+void timestep_view_set_y(timestep_view *v, double y);
+double timestep_view_get_width(timestep_view *v);
+void timestep_view_set_width(timestep_view *v, double width);
+double timestep_view_get_height(timestep_view *v);
+void timestep_view_set_height(timestep_view *v, double height);
+double timestep_view_get_width_percent(timestep_view *v);
+void timestep_view_set_width_percent(timestep_view *v, double width_percent);
+double timestep_view_get_height_percent(timestep_view *v);
+void timestep_view_set_height_percent(timestep_view *v, double height_percent);
+double timestep_view_get_offset_x(timestep_view *v);
+void timestep_view_set_offset_x(timestep_view *v, double offset_x);
+double timestep_view_get_offset_y(timestep_view *v);
+void timestep_view_set_offset_y(timestep_view *v, double offset_y);
+double timestep_view_get_r(timestep_view *v);
+void timestep_view_set_r(timestep_view *v, double r);
+double timestep_view_get_anchor_x(timestep_view *v);
+void timestep_view_set_anchor_x(timestep_view *v, double anchor_x);
+double timestep_view_get_anchor_y(timestep_view *v);
+void timestep_view_set_anchor_y(timestep_view *v, double anchor_y);
+double timestep_view_get_opacity(timestep_view *v);
+void timestep_view_set_opacity(timestep_view *v, double opacity);
+double timestep_view_get_scale(timestep_view *v);
+void timestep_view_set_scale(timestep_view *v, double scale);
+bool timestep_view_get_visible(timestep_view *v);
+void timestep_view_set_visible(timestep_view *v, bool visible);
+
 void timestep_view_delete(timestep_view *v);
 void timestep_view_wrap_render(timestep_view *v, context_2d *ctx, JS_OBJECT_WRAPPER js_ctx, JS_OBJECT_WRAPPER js_opts);
 void timestep_view_set_type(timestep_view *v, unsigned int type);
+void timestep_view_apply_local_transform(timestep_view *v, matrix_2x3 *m);
+void timestep_view_set_cache_as_bitmap(timestep_view *v, bool cache_as_bitmap);
+void timestep_view_invalidate_cache(timestep_view *v);
+void timestep_view_set_display_list(timestep_view *v, bool use_display_list);
+void timestep_view_invalidate_display_list(timestep_view *v);
 
 void timestep_view_wrap_tick(timestep_view *v, double dt);
+void timestep_view_set_has_jstick(timestep_view *v, bool has_jstick);
+void timestep_view_set_tick(timestep_view *v, void (*tick)(timestep_view*, double));
+// Registers the tick of the bindings that calls the tick of each js view in
+// order. The array is only valid for the duration of the call. NULL ticks
+// each js view through def_timestep_view_tick.
+void timestep_view_set_tick_batch(void (*tick_batch)(JS_OBJECT_WRAPPER*, unsigned int, double));
 void timestep_view_sort_subviews(timestep_view *v);
+void timestep_view_compact_subviews(timestep_view *v);
 bool timestep_view_add_subview(timestep_view *v, timestep_view *subview);
 bool timestep_view_remove_subview(timestep_view *v, timestep_view *subview);
 timestep_view *timestep_view_get_superview(timestep_view *v);